@@ -0,0 +1,128 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+
+// Build step: decodes the embedded GIMP header textures to RGBA8 and writes
+// an assembly file that pulls each of them into the binary once with
+// .incbin, see assets.h. Runs on the build machine, the Makefile builds and
+// runs it before linking stress-weston:
+//
+//	asset-gen <output directory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "texture-decode.h"
+
+#include "digits.h"
+#include "needle.h"
+#include "dialface.h"
+#include "store1k.h"
+
+struct texture_source {
+	const char* name;
+	unsigned int width;
+	unsigned int height;
+	const char* data;
+	int alpha_style;
+};
+
+// one entry per image, the alpha style each scene registered it with.
+// Keep in sync with the TEXTURE_ASSET() list in assets.h
+static const texture_source g_sources[] = {
+	{ "digits",	image_digits::width,	image_digits::height,	image_digits::header_data,	0 },
+	{ "needle",	image_needle::width,	image_needle::height,	image_needle::header_data,	1 },
+	{ "dial",	image_dial::width,	image_dial::height,	image_dial::header_data,	2 },
+	{ "store1k",	image_1k::width,	image_1k::height,	image_1k::header_data,		2 },
+};
+
+//------------------------------------------------------------------------------
+static void write_pixels(const char* path, const texture_source& source)
+{
+	size_t size = (size_t)source.width * source.height * 4;
+	unsigned char* pixels = new unsigned char[size];
+	decode_texture(source.data, pixels, source.width * source.height, source.alpha_style);
+
+	FILE* file = fopen(path, "wb");
+	if(NULL == file || size != fwrite(pixels, 1, size, file))
+	{
+		printf("asset-gen: unable to write %s\n", path);
+		exit(1);
+	}
+	fclose(file);
+	delete[] pixels;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	if(2 != argc)
+	{
+		printf("usage: asset-gen <output directory>\n");
+		return 1;
+	}
+	const char* dir = argv[1];
+
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/assets.S", dir);
+	FILE* assembly = fopen(path, "w");
+	if(NULL == assembly)
+	{
+		printf("asset-gen: unable to write %s\n", path);
+		return 1;
+	}
+
+	fprintf(assembly, "// generated by asset-gen, do not edit\n");
+	fprintf(assembly, "\t.section .rodata\n");
+	for(unsigned int i=0; i<sizeof(g_sources)/sizeof(g_sources[0]); i++)
+	{
+		const texture_source& source = g_sources[i];
+
+		snprintf(path, sizeof(path), "%s/%s.rgba", dir, source.name);
+		write_pixels(path, source);
+
+		// 16 byte aligned, like a heap allocation of the pixels would be
+		fprintf(assembly, "\n\t.balign 16\n");
+		fprintf(assembly, "\t.global asset_%s_pixels\n", source.name);
+		fprintf(assembly, "\t.type asset_%s_pixels, %%object\n", source.name);
+		fprintf(assembly, "asset_%s_pixels:\n", source.name);
+		fprintf(assembly, "\t.incbin \"%s\"\n", path);
+		fprintf(assembly, "\t.size asset_%s_pixels, . - asset_%s_pixels\n", source.name, source.name);
+
+		fprintf(assembly, "\t.balign 4\n");
+		fprintf(assembly, "\t.global asset_%s_width\n", source.name);
+		fprintf(assembly, "\t.type asset_%s_width, %%object\n", source.name);
+		fprintf(assembly, "\t.size asset_%s_width, 4\n", source.name);
+		fprintf(assembly, "asset_%s_width:\n\t.long %u\n", source.name, source.width);
+		fprintf(assembly, "\t.global asset_%s_height\n", source.name);
+		fprintf(assembly, "\t.type asset_%s_height, %%object\n", source.name);
+		fprintf(assembly, "\t.size asset_%s_height, 4\n", source.name);
+		fprintf(assembly, "asset_%s_height:\n\t.long %u\n", source.name, source.height);
+
+		printf("asset-gen: %s %ux%u\n", source.name, source.width, source.height);
+	}
+
+	// the blobs are data, keep the stack non-executable
+	fprintf(assembly, "\n\t.section .note.GNU-stack,\"\",%%progbits\n");
+	fclose(assembly);
+
+	return 0;
+}
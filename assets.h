@@ -0,0 +1,40 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+// The embedded textures, decoded to RGBA8 at build time by asset-gen.cpp and
+// linked in once each from the generated assets.S. Upload them with
+// uploadTexture(), there is nothing left to decode at startup.
+#define TEXTURE_ASSET(name) \
+	extern "C" const unsigned char asset_##name##_pixels[]; \
+	extern "C" const unsigned int asset_##name##_width; \
+	extern "C" const unsigned int asset_##name##_height;
+
+TEXTURE_ASSET(digits)
+TEXTURE_ASSET(needle)
+TEXTURE_ASSET(dial)
+TEXTURE_ASSET(store1k)
+
+#undef TEXTURE_ASSET
+
+#endif
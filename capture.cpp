@@ -0,0 +1,365 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "main.h"
+#include "capture.h"
+#include "frame-queue.h"
+
+struct capture_file {
+	frame_queue* queue;
+	FILE* file;
+	const char* filename;
+	uint64_t start_us;
+
+	// written by the writer only
+	int width, height;			// of the first frame, the file's size
+	std::vector<unsigned char> planes;
+	uint64_t frames, bytes;
+	uint64_t skipped_size, skipped_format;
+	uint64_t convert_sum_us, write_sum_us;
+};
+
+static capture_file g_capture;
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// full range BT.601 in 8 bit fixed point, the same arithmetic as the SSE2
+// path: the chroma sums can reach 32768 before the shift, they saturate
+//------------------------------------------------------------------------------
+static inline unsigned char luma(int r, int g, int b)
+{
+	return (unsigned char)((77*r + 150*g + 29*b + 128) >> 8);
+}
+
+//------------------------------------------------------------------------------
+static inline unsigned char chroma(int t)
+{
+	t += 128;
+	if(t > 32767)
+	{
+		t = 32767;
+	}
+	return (unsigned char)((t >> 8) + 128);
+}
+
+// one chroma sample from the 2x2 pixels at column x of two rows
+//------------------------------------------------------------------------------
+static void chroma_block(const unsigned char* top, const unsigned char* bottom, int x, int width,
+						 unsigned char* u, unsigned char* v)
+{
+	int x1 = (x + 1 < width) ? x + 1 : x;
+	int r = (top[4*x + 0] + top[4*x1 + 0] + bottom[4*x + 0] + bottom[4*x1 + 0] + 2) >> 2;
+	int g = (top[4*x + 1] + top[4*x1 + 1] + bottom[4*x + 1] + bottom[4*x1 + 1] + 2) >> 2;
+	int b = (top[4*x + 2] + top[4*x1 + 2] + bottom[4*x + 2] + bottom[4*x1 + 2] + 2) >> 2;
+	*u = chroma(-43*r - 85*g + 128*b);
+	*v = chroma(128*r - 107*g - 21*b);
+}
+
+#ifdef __SSE2__
+// the R, G and B of 8 pixels as 16 bit lanes
+//------------------------------------------------------------------------------
+static inline void load_rgb(const unsigned char* rgba, __m128i& r, __m128i& g, __m128i& b)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	__m128i p0 = _mm_loadu_si128((const __m128i*)rgba);
+	__m128i p1 = _mm_loadu_si128((const __m128i*)(rgba + 16));
+	r = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+	g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask), _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+	b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask), _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+// 8 luma values, the products wrap but the sum fits in 16 bits unsigned
+//------------------------------------------------------------------------------
+static inline void store_luma(__m128i r, __m128i g, __m128i b, unsigned char* y)
+{
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)), _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+	sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(29)), _mm_set1_epi16(128)));
+	sum = _mm_srli_epi16(sum, 8);
+	_mm_storel_epi64((__m128i*)y, _mm_packus_epi16(sum, sum));
+}
+
+// 4 chroma values from the weighted 2x2 averages
+//------------------------------------------------------------------------------
+static inline void store_chroma(__m128i r, __m128i g, __m128i b, short kr, short kg, short kb, unsigned char* c)
+{
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kr)), _mm_mullo_epi16(g, _mm_set1_epi16(kg)));
+	t = _mm_add_epi16(t, _mm_mullo_epi16(b, _mm_set1_epi16(kb)));
+	t = _mm_adds_epi16(t, _mm_set1_epi16(128));
+	t = _mm_add_epi16(_mm_srai_epi16(t, 8), _mm_set1_epi16(128));
+	int packed = _mm_cvtsi128_si32(_mm_packus_epi16(t, t));
+	memcpy(c, &packed, 4);
+}
+
+// the average of 2x2 blocks: 8 pixels of two rows to 4 values
+//------------------------------------------------------------------------------
+static inline __m128i average_blocks(__m128i top, __m128i bottom)
+{
+	__m128i sums = _mm_madd_epi16(_mm_add_epi16(top, bottom), _mm_set1_epi16(1));
+	sums = _mm_packs_epi32(sums, sums);
+	return _mm_srli_epi16(_mm_add_epi16(sums, _mm_set1_epi16(2)), 2);
+}
+
+// 8 pixels of two rows at a time, returns the first column left over
+//------------------------------------------------------------------------------
+static int convert_rows(const unsigned char* top, const unsigned char* bottom, int width,
+						unsigned char* y_top, unsigned char* y_bottom, unsigned char* u, unsigned char* v)
+{
+	int x = 0;
+	for(; x + 8 <= width; x += 8)
+	{
+		__m128i rt, gt, bt, rb, gb, bb;
+		load_rgb(top + 4*x, rt, gt, bt);
+		load_rgb(bottom + 4*x, rb, gb, bb);
+
+		store_luma(rt, gt, bt, y_top + x);
+		if(y_bottom)
+		{
+			store_luma(rb, gb, bb, y_bottom + x);
+		}
+
+		__m128i r = average_blocks(rt, rb);
+		__m128i g = average_blocks(gt, gb);
+		__m128i b = average_blocks(bt, bb);
+		store_chroma(r, g, b, -43, -85, 128, u + x/2);
+		store_chroma(r, g, b, 128, -107, -21, v + x/2);
+	}
+	return x;
+}
+#else
+//------------------------------------------------------------------------------
+static int convert_rows(const unsigned char* top, const unsigned char* bottom, int width,
+						unsigned char* y_top, unsigned char* y_bottom, unsigned char* u, unsigned char* v)
+{
+	return 0;
+}
+#endif
+
+// bottom-up RGBA8 rows to 4:2:0 full range BT.601 planes, top row first.
+// 'u' and 'v' are (width+1)/2 by (height+1)/2
+//------------------------------------------------------------------------------
+void rgba_to_yuv420(const unsigned char* rgba, int width, int height,
+					unsigned char* y, unsigned char* u, unsigned char* v)
+{
+	int chroma_width = (width + 1) / 2;
+	size_t stride = (size_t)width * 4;
+
+	for(int row=0; row<height; row+=2)
+	{
+		// GL rows start at the bottom, the last odd row pairs with itself
+		const unsigned char* top = rgba + (height - 1 - row) * stride;
+		const unsigned char* bottom = (row + 1 < height) ? top - stride : top;
+		unsigned char* y_top = y + (size_t)row * width;
+		unsigned char* y_bottom = (row + 1 < height) ? y_top + width : NULL;
+		unsigned char* u_row = u + (size_t)(row / 2) * chroma_width;
+		unsigned char* v_row = v + (size_t)(row / 2) * chroma_width;
+
+		int done = convert_rows(top, bottom, width, y_top, y_bottom, u_row, v_row);
+		for(int x=done; x<width; x++)
+		{
+			y_top[x] = luma(top[4*x], top[4*x + 1], top[4*x + 2]);
+			if(y_bottom)
+			{
+				y_bottom[x] = luma(bottom[4*x], bottom[4*x + 1], bottom[4*x + 2]);
+			}
+		}
+		for(int x=done; x<width; x+=2)
+		{
+			chroma_block(top, bottom, x, width, u_row + x/2, v_row + x/2);
+		}
+	}
+}
+
+// the stream header, the size and rate of every frame that follows
+//------------------------------------------------------------------------------
+static void write_y4m_header(int width, int height)
+{
+	// without a fixed timestep the frame rate isn't known up front, players
+	// get 60 fps
+	if(g_fixedTimestep)
+	{
+		fprintf(g_capture.file, "YUV4MPEG2 W%d H%d F1000000:%u Ip A1:1 C420jpeg\n",
+			width, height, g_fixedTimestep * g_captureInterval);
+	}
+	else
+	{
+		fprintf(g_capture.file, "YUV4MPEG2 W%d H%d F60:%u Ip A1:1 C420jpeg\n", width, height, g_captureInterval);
+	}
+}
+
+// the writer: convert the frame and append it to the file
+//------------------------------------------------------------------------------
+static void write_frame(const queued_frame& frame, void* data)
+{
+	if(4 != frame.bytes_per_pixel)
+	{
+		if(0 == g_capture.skipped_format++)
+		{
+			printf("Capture: only RGBA8 frames can be captured, skipping frames of %d bytes per pixel\n", frame.bytes_per_pixel);
+		}
+		return;
+	}
+
+	if(0 == g_capture.frames)
+	{
+		g_capture.width = frame.width;
+		g_capture.height = frame.height;
+		if(captureY4M == g_captureMode)
+		{
+			write_y4m_header(frame.width, frame.height);
+		}
+		printf("Capture: %s frames of (%d,%d) to %s\n", (captureY4M == g_captureMode) ? "YUV4MPEG2" : "raw RGBA",
+			frame.width, frame.height, g_capture.filename);
+	}
+	else if((frame.width != g_capture.width) || (frame.height != g_capture.height))
+	{
+		g_capture.skipped_size++;
+		return;
+	}
+
+	uint64_t start = monotonic_now_us();
+	size_t size;
+	if(captureY4M == g_captureMode)
+	{
+		size_t luma_size = (size_t)frame.width * frame.height;
+		size_t chroma_size = (size_t)((frame.width + 1) / 2) * ((frame.height + 1) / 2);
+		size = luma_size + 2 * chroma_size;
+		g_capture.planes.resize(size);
+		unsigned char* y = &g_capture.planes[0];
+		rgba_to_yuv420(frame.pixels, frame.width, frame.height, y, y + luma_size, y + luma_size + chroma_size);
+
+		uint64_t converted = monotonic_now_us();
+		g_capture.convert_sum_us += converted - start;
+		start = converted;
+
+		fputs("FRAME\n", g_capture.file);
+		fwrite(y, 1, size, g_capture.file);
+	}
+	else
+	{
+		// top row first, like the Y4M frames
+		size_t stride = (size_t)frame.width * 4;
+		size = stride * frame.height;
+		for(int row=frame.height-1; row>=0; row--)
+		{
+			fwrite(frame.pixels + row * stride, 1, stride, g_capture.file);
+		}
+	}
+	g_capture.write_sum_us += monotonic_now_us() - start;
+	g_capture.frames++;
+	g_capture.bytes += size;
+}
+
+// open the capture file and start the writer, exits when the file can't be
+// created. A NULL filename picks capture.y4m or capture.rgba
+//------------------------------------------------------------------------------
+void capture_start(const char* filename)
+{
+	if(!capture_enabled())
+	{
+		return;
+	}
+
+	if(!filename)
+	{
+		filename = (captureY4M == g_captureMode) ? "capture.y4m" : "capture.rgba";
+	}
+	g_capture.file = fopen(filename, "wb");
+	if(!g_capture.file)
+	{
+		printf("Capture: can't create %s\n", filename);
+		exit(1);
+	}
+	g_capture.filename = filename;
+	g_capture.start_us = monotonic_now_us();
+	g_capture.queue = frame_queue_start("Capture", g_captureQueue, write_frame, NULL);
+}
+
+//------------------------------------------------------------------------------
+bool capture_enabled()
+{
+	return (captureY4M == g_captureMode) || (captureRaw == g_captureMode);
+}
+
+// this frame of the surface gets captured
+//------------------------------------------------------------------------------
+bool capture_wanted(const window* win)
+{
+	return g_capture.queue && (0 == win->surface_index) && (0 == (win->frame_id % g_captureInterval));
+}
+
+// where the frame's pixels are read to, NULL when the writer is behind and
+// the frame is dropped
+//------------------------------------------------------------------------------
+unsigned char* capture_buffer(size_t size)
+{
+	return g_capture.queue ? frame_queue_acquire(g_capture.queue, size) : NULL;
+}
+
+// write the frame in a buffer from capture_buffer()
+//------------------------------------------------------------------------------
+void capture_submit(const window* win, uint64_t frame_id, unsigned char* pixels,
+					int width, int height, int bytes_per_pixel)
+{
+	frame_queue_submit(g_capture.queue, pixels, win->surface_index, frame_id, width, height, bytes_per_pixel);
+}
+
+// write the frames that were submitted, print the capture stats and close
+// the file
+//------------------------------------------------------------------------------
+void capture_stop()
+{
+	if(!g_capture.queue)
+	{
+		return;
+	}
+	uint64_t dropped = frame_queue_dropped(g_capture.queue);
+	frame_queue_stop(g_capture.queue);
+	g_capture.queue = NULL;
+	fclose(g_capture.file);
+	g_capture.file = NULL;
+
+	double seconds = (monotonic_now_us() - g_capture.start_us) / 1000000.0;
+	uint64_t frames = g_capture.frames ? g_capture.frames : 1;
+	printf("Capture: %llu frames written to %s, %.1f MB at %.1f MB/s, %.3f ms converting and %.3f ms writing per frame, %llu dropped, %llu skipped\n",
+		(unsigned long long)g_capture.frames, g_capture.filename,
+		g_capture.bytes / 1000000.0,
+		seconds > 0.0 ? g_capture.bytes / seconds / 1000000.0 : 0.0,
+		(double)g_capture.convert_sum_us / frames / 1000.0,
+		(double)g_capture.write_sum_us / frames / 1000.0,
+		(unsigned long long)dropped,
+		(unsigned long long)(g_capture.skipped_size + g_capture.skipped_format));
+}
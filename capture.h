@@ -0,0 +1,71 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame capture
+// Writes every g_captureInterval-th frame (params file line 48) of the first
+// surface to a file, for looking through long soak runs afterwards and as a
+// capture workload with a realistic GPU to CPU bandwidth cost. The frames
+// are read back through the readback ring (see readback.h) and converted
+// and written on a writer thread with g_captureQueue (line 49) buffers (see
+// frame-queue.h); when the writer falls behind, frames are dropped and
+// counted. YUV4MPEG2 (line 47 = 1) is 4:2:0 and plays in most video players,
+// raw (2) is the RGBA8 pixels, top row first. The size of the first frame
+// is kept, frames of another size are skipped.
+enum CaptureModes {
+	captureOff = 0,
+	captureY4M,
+	captureRaw,
+	captureModeCount,
+};
+
+// open the capture file and start the writer, exits when the file can't be
+// created. A NULL filename picks capture.y4m or capture.rgba
+void capture_start(const char* filename);
+
+bool capture_enabled();
+
+// this frame of the surface gets captured
+bool capture_wanted(const window* win);
+
+// where the frame's pixels are read to, NULL when the writer is behind and
+// the frame is dropped
+unsigned char* capture_buffer(size_t size);
+
+// write the frame in a buffer from capture_buffer()
+void capture_submit(const window* win, uint64_t frame_id, unsigned char* pixels,
+					int width, int height, int bytes_per_pixel);
+
+// write the frames that were submitted, print the capture stats and close
+// the file
+void capture_stop();
+
+// bottom-up RGBA8 rows to 4:2:0 full range BT.601 planes, top row first.
+// 'u' and 'v' are (width+1)/2 by (height+1)/2
+void rgba_to_yuv420(const unsigned char* rgba, int width, int height,
+					unsigned char* y, unsigned char* u, unsigned char* v);
+
+#endif // __CAPTURE_H__
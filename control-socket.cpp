@@ -0,0 +1,352 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include <sstream>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "control-socket.h"
+
+#define MAX_CONTROL_CLIENTS 8
+#define MAX_COMMAND_LENGTH 1024
+
+static int g_listen_fd = -1;
+static std::string g_socket_path;
+
+static struct {
+	int fd;
+	std::string input;
+} g_clients[MAX_CONTROL_CLIENTS];
+
+static int g_client_count = 0;
+
+//------------------------------------------------------------------------------
+bool control_socket_init(const char* path)
+{
+	struct sockaddr_un addr;
+
+	if(strlen(path) >= sizeof(addr.sun_path))
+	{
+		printf("Control socket path too long: %s\n", path);
+		return false;
+	}
+
+	g_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(g_listen_fd < 0)
+	{
+		printf("Unable to create control socket: %s\n", strerror(errno));
+		return false;
+	}
+
+	// remove a stale socket left behind by a previous run
+	unlink(path);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	if(bind(g_listen_fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(g_listen_fd, MAX_CONTROL_CLIENTS))
+	{
+		printf("Unable to listen on control socket %s: %s\n", path, strerror(errno));
+		close(g_listen_fd);
+		g_listen_fd = -1;
+		return false;
+	}
+
+	g_socket_path = path;
+	printf("Listening for commands on %s\n", path);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+static void send_reply(int fd, const std::string& reply)
+{
+	std::string line = reply + "\n";
+
+	// replies are short, if the client doesn't read them they get dropped
+	// rather than stalling the render loop
+	if(send(fd, line.c_str(), line.length(), MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+	{
+		printf("Control socket: dropped reply (%s)\n", strerror(errno));
+	}
+}
+
+//------------------------------------------------------------------------------
+static void remove_client(int index)
+{
+	close(g_clients[index].fd);
+	g_client_count--;
+	g_clients[index].fd = g_clients[g_client_count].fd;
+	g_clients[index].input.swap(g_clients[g_client_count].input);
+	g_clients[g_client_count].input.clear();
+}
+
+// parse a scene given either as a number or by name
+//------------------------------------------------------------------------------
+static bool parse_scene(const std::string& arg, DrawCases& drawcase)
+{
+	for(int i=simpleDial; i<next_case; i++)
+	{
+		if(arg == draw_case_name((DrawCases)i))
+		{
+			drawcase = (DrawCases)i;
+			return true;
+		}
+	}
+
+	char* end = NULL;
+	long value = strtol(arg.c_str(), &end, 10);
+	if(arg.empty() || *end || !draw_case_valid(value))
+	{
+		return false;
+	}
+
+	drawcase = (DrawCases)value;
+	return true;
+}
+
+// run one command line and return the reply
+//------------------------------------------------------------------------------
+static std::string run_command(window* win, const std::string& line)
+{
+	std::istringstream args(line);
+	std::string command, arg, value;
+	char buffer[512];
+
+	args >> command >> arg >> value;
+
+	if(command == "help")
+	{
+		return "ok commands: scene [next|<n>|<name>], set <param> <value>, get <param>, params, metrics start|stop, stats, quit";
+	}
+	else if(command == "scene")
+	{
+		if(arg == "next")
+		{
+			swap_draw_case(win);
+		}
+		else if(!arg.empty())
+		{
+			DrawCases drawcase;
+			if(!parse_scene(arg, drawcase))
+			{
+				return "error unknown scene " + arg;
+			}
+			swap_draw_case(win, drawcase);
+		}
+
+		snprintf(buffer, sizeof(buffer), "ok %d %s", win->draw_case, draw_case_name(win->draw_case));
+		return buffer;
+	}
+	else if(command == "set")
+	{
+		switch(set_parameter(win, arg.c_str(), value.c_str()))
+		{
+			case 0:
+				break;
+			case -1:
+				return "error unknown parameter " + arg;
+			default:
+				return "error invalid value '" + value + "' for " + arg;
+		}
+
+		// report the value actually in use, it may have been clamped or
+		// refused if it can't be changed while running
+		get_parameter(arg.c_str(), value);
+		return "ok " + arg + " " + value;
+	}
+	else if(command == "get")
+	{
+		if(!get_parameter(arg.c_str(), value))
+		{
+			return "error unknown parameter " + arg;
+		}
+		return "ok " + arg + " " + value;
+	}
+	else if(command == "params")
+	{
+		return "ok " + list_parameters();
+	}
+	else if(command == "metrics")
+	{
+		if(arg == "start")
+		{
+			set_metrics_recording(true);
+		}
+		else if(arg == "stop")
+		{
+			set_metrics_recording(false);
+		}
+		else
+		{
+			return "error expected metrics start|stop";
+		}
+		return "ok metrics " + arg;
+	}
+	else if(command == "stats")
+	{
+		snprintf(buffer, sizeof(buffer), "ok scene=%s fps=%.2f frame_us=%u present_us=%u frames=%llu metrics=%d",
+			draw_case_name(win->draw_case),
+			win->fps,
+			win->frame_time_us,
+			win->present_time_us,
+			(unsigned long long)win->frame_id,
+			g_recordMetrics ? 1 : 0);
+		return buffer;
+	}
+	else if(command == "quit")
+	{
+		request_exit();
+		return "ok";
+	}
+
+	return "error unknown command '" + command + "'";
+}
+
+// read whatever a client sent and run each complete line
+// returns false once the client has gone away
+//------------------------------------------------------------------------------
+static bool service_client(window* win, int index)
+{
+	char data[MAX_COMMAND_LENGTH];
+
+	for(;;)
+	{
+		ssize_t len = recv(g_clients[index].fd, data, sizeof(data), MSG_DONTWAIT);
+		if(0 == len)
+		{
+			return false;
+		}
+		if(len < 0)
+		{
+			if(EAGAIN == errno || EWOULDBLOCK == errno)
+			{
+				break;
+			}
+			return false;
+		}
+		g_clients[index].input.append(data, len);
+	}
+
+	std::string& input = g_clients[index].input;
+	size_t newline;
+	while(std::string::npos != (newline = input.find('\n')))
+	{
+		std::string line = input.substr(0, newline);
+		input.erase(0, newline + 1);
+
+		if(!line.empty() && '\r' == line[line.length()-1])
+		{
+			line.erase(line.length()-1);
+		}
+
+		if(!line.empty())
+		{
+			send_reply(g_clients[index].fd, run_command(win, line));
+		}
+	}
+
+	// refuse to buffer endless garbage
+	if(input.length() > MAX_COMMAND_LENGTH)
+	{
+		send_reply(g_clients[index].fd, "error command too long");
+		return false;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void control_socket_service(window* win)
+{
+	if(g_listen_fd < 0)
+	{
+		return;
+	}
+
+	struct pollfd fds[MAX_CONTROL_CLIENTS + 1];
+	fds[0].fd = g_listen_fd;
+	fds[0].events = POLLIN;
+	for(int i=0; i<g_client_count; i++)
+	{
+		fds[i+1].fd = g_clients[i].fd;
+		fds[i+1].events = POLLIN;
+	}
+
+	// zero timeout, rendering must never wait on a client
+	if(poll(fds, g_client_count + 1, 0) <= 0)
+	{
+		return;
+	}
+
+	// walk backwards so removing a client doesn't skip the next one
+	for(int i=g_client_count-1; i>=0; i--)
+	{
+		if(fds[i+1].revents && !service_client(win, i))
+		{
+			remove_client(i);
+		}
+	}
+
+	if(fds[0].revents & POLLIN)
+	{
+		int fd;
+		while((fd = accept4(g_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+		{
+			if(g_client_count >= MAX_CONTROL_CLIENTS)
+			{
+				send_reply(fd, "error too many clients");
+				close(fd);
+				continue;
+			}
+			g_clients[g_client_count].fd = fd;
+			g_clients[g_client_count].input.clear();
+			g_client_count++;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+void control_socket_close()
+{
+	while(g_client_count)
+	{
+		remove_client(g_client_count-1);
+	}
+
+	if(g_listen_fd >= 0)
+	{
+		close(g_listen_fd);
+		unlink(g_socket_path.c_str());
+	}
+	g_listen_fd = -1;
+}
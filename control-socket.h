@@ -0,0 +1,40 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __CONTROL_SOCKET_H__
+#define __CONTROL_SOCKET_H__
+
+#include "main.h"
+
+// Unix domain socket for driving a running instance remotely.
+// Commands are single text lines, each one gets a single line reply 
+// starting with 'ok' or 'error'. Send 'help' for the list of commands.
+
+// create the listening socket at the given path
+bool control_socket_init(const char* path);
+
+// accept clients and run any complete commands, never blocks
+// call once per frame from the main loop
+void control_socket_service(window* win);
+
+void control_socket_close();
+
+#endif // __CONTROL_SOCKET_H__
@@ -0,0 +1,318 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+
+#include "main.h"
+#include "damage.h"
+
+// stress tiles, in window pixels
+#define MAX_STRESS_TILES	1024
+#define STRESS_TILE_SIZE	32
+
+// a couple of pixels around each rect for filtering and rasterization
+#define DAMAGE_MARGIN		2
+
+struct damage_frame {
+	EGLint rects[4*MAX_DAMAGE_RECTS];	// x, y, width, height
+	int count;
+	bool full;
+};
+
+struct damage_state {
+	damage_frame current;
+
+	// the frames before, history[history_index] is the oldest
+	damage_frame history[DAMAGE_HISTORY];
+	int history_index;
+
+	// the first frame, a new size or a new scene damage everything
+	int width, height;
+	DrawCases draw_case;
+
+	// the rects sent with the swap, the stress tiles or this and the
+	// previous frame's damage (never more than MAX_STRESS_TILES)
+	EGLint swap_rects[4*MAX_STRESS_TILES];
+};
+
+//------------------------------------------------------------------------------
+static const damage_frame& previous_frame(const damage_state* damage, int age)
+{
+	return damage->history[(damage->history_index + DAMAGE_HISTORY - age) % DAMAGE_HISTORY];
+}
+
+// start collecting the damage of a new frame
+//------------------------------------------------------------------------------
+void damage_begin(window* win)
+{
+	if(NULL == win->damage)
+	{
+		win->damage = new damage_state;
+		for(int i=0; i<DAMAGE_HISTORY; i++)
+		{
+			win->damage->history[i].count = 0;
+			win->damage->history[i].full = true;
+		}
+		win->damage->history_index = 0;
+		win->damage->width = win->geometry.width;
+		win->damage->height = win->geometry.height;
+		win->damage->draw_case = win->draw_case;
+	}
+	damage_state* damage = win->damage;
+	damage->current.count = 0;
+	damage->current.full = false;
+
+	if((damage->width != win->geometry.width) || (damage->height != win->geometry.height) ||
+		(damage->draw_case != win->draw_case))
+	{
+		damage->width = win->geometry.width;
+		damage->height = win->geometry.height;
+		damage->draw_case = win->draw_case;
+		damage->current.full = true;
+	}
+}
+
+// the whole surface changed
+//------------------------------------------------------------------------------
+void damage_add_full(window* win)
+{
+	win->damage->current.full = true;
+}
+
+// a rectangle in normalized device coordinates changed
+//------------------------------------------------------------------------------
+void damage_add_ndc(window* win, float x0, float y0, float x1, float y1)
+{
+	damage_frame* damage = &win->damage->current;
+	if(damage->full)
+	{
+		return;
+	}
+	if(damage->count >= MAX_DAMAGE_RECTS)
+	{
+		damage->full = true;
+		return;
+	}
+
+	// normalized device coordinates and EGL damage both start bottom-left
+	int width = win->geometry.width;
+	int height = win->geometry.height;
+	int left   = (int)((std::min(x0, x1) + 1.0f) * 0.5f * width) - DAMAGE_MARGIN;
+	int right  = (int)((std::max(x0, x1) + 1.0f) * 0.5f * width) + DAMAGE_MARGIN;
+	int bottom = (int)((std::min(y0, y1) + 1.0f) * 0.5f * height) - DAMAGE_MARGIN;
+	int top    = (int)((std::max(y0, y1) + 1.0f) * 0.5f * height) + DAMAGE_MARGIN;
+	left = std::max(left, 0);
+	bottom = std::max(bottom, 0);
+	right = std::min(right, width);
+	top = std::min(top, height);
+	if((right <= left) || (top <= bottom))
+	{
+		return;
+	}
+
+	EGLint* rect = &damage->rects[4*damage->count++];
+	rect[0] = left;
+	rect[1] = bottom;
+	rect[2] = right - left;
+	rect[3] = top - bottom;
+}
+
+// the [-1,1] quad transformed by the 4x4 column major matrix 'mvp' changed
+//------------------------------------------------------------------------------
+void damage_add_quad(window* win, const float* mvp)
+{
+	static const float corners[4][2] = { {-1.0f,-1.0f}, {1.0f,-1.0f}, {1.0f,1.0f}, {-1.0f,1.0f} };
+
+	float x0 = 1e9f, y0 = 1e9f, x1 = -1e9f, y1 = -1e9f;
+	for(int i=0; i<4; i++)
+	{
+		float x = mvp[0]*corners[i][0] + mvp[4]*corners[i][1] + mvp[12];
+		float y = mvp[1]*corners[i][0] + mvp[5]*corners[i][1] + mvp[13];
+		float w = mvp[3]*corners[i][0] + mvp[7]*corners[i][1] + mvp[15];
+		if(w <= 0.0f)
+		{
+			// behind the eye, don't guess
+			damage_add_full(win);
+			return;
+		}
+		x /= w;
+		y /= w;
+		x0 = std::min(x0, x);
+		y0 = std::min(y0, y);
+		x1 = std::max(x1, x);
+		y1 = std::max(y1, y);
+	}
+	damage_add_ndc(win, x0, y0, x1, y1);
+}
+
+// scattered tiles, the same ones for the same frame of every run
+//------------------------------------------------------------------------------
+static int stress_tiles(window* win, EGLint* tiles, unsigned int count)
+{
+	uint32_t seed = (uint32_t)win->frame_id * 2654435761u + win->surface_index;
+	int width = std::max(win->geometry.width - STRESS_TILE_SIZE, 1);
+	int height = std::max(win->geometry.height - STRESS_TILE_SIZE, 1);
+
+	count = std::min(count, (unsigned int)MAX_STRESS_TILES);
+	for(unsigned int i=0; i<count; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		tiles[4*i+0] = (seed >> 8) % width;
+		seed = seed * 1664525u + 1013904223u;
+		tiles[4*i+1] = (seed >> 8) % height;
+		tiles[4*i+2] = STRESS_TILE_SIZE;
+		tiles[4*i+3] = STRESS_TILE_SIZE;
+	}
+	return count;
+}
+
+// the back buffer's age, the number of frames since its content was drawn,
+// 0 when it is unknown
+//------------------------------------------------------------------------------
+static int buffer_age(window* win)
+{
+	display* display = win->display;
+
+	// the offscreen framebuffer is not a window buffer
+	EGLint age = 0;
+	if(display->swap_buffers_with_damage && !win->offscreen && !win->headless)
+	{
+		eglQuerySurface(display->egl.dpy, win->egl_surface, EGL_BUFFER_AGE_EXT, &age);
+	}
+	return age;
+}
+
+//------------------------------------------------------------------------------
+static bool rects_overlap(const EGLint* a, const EGLint* b)
+{
+	return (a[0] <= b[0] + b[2]) && (b[0] <= a[0] + a[2]) &&
+		(a[1] <= b[1] + b[3]) && (b[1] <= a[1] + a[3]);
+}
+
+// merge 'rect' into the list, joining every rect it overlaps
+//------------------------------------------------------------------------------
+static void merge_rect(EGLint* rects, int& count, const EGLint* rect)
+{
+	EGLint merged[4] = { rect[0], rect[1], rect[2], rect[3] };
+
+	for(int i=0; i<count; )
+	{
+		EGLint* other = &rects[4*i];
+		if(!rects_overlap(merged, other))
+		{
+			i++;
+			continue;
+		}
+
+		EGLint left = std::min(merged[0], other[0]);
+		EGLint bottom = std::min(merged[1], other[1]);
+		EGLint right = std::max(merged[0] + merged[2], other[0] + other[2]);
+		EGLint top = std::max(merged[1] + merged[3], other[1] + other[3]);
+		merged[0] = left;
+		merged[1] = bottom;
+		merged[2] = right - left;
+		merged[3] = top - bottom;
+
+		// the joined rect may overlap one that was already checked
+		count--;
+		std::copy(&rects[4*count], &rects[4*count+4], other);
+		i = 0;
+	}
+	std::copy(merged, merged + 4, &rects[4*count]);
+	count++;
+}
+
+// what has to be redrawn in the back buffer, the damage of every frame
+// since the buffer was last drawn
+//------------------------------------------------------------------------------
+bool damage_repaint_rects(window* win, EGLint* rects, int& count)
+{
+	damage_state* damage = win->damage;
+	int age = buffer_age(win);
+
+	count = 0;
+	if((0 == age) || (age > DAMAGE_HISTORY) || damage->current.full)
+	{
+		return false;
+	}
+
+	for(int i=0; i<damage->current.count; i++)
+	{
+		merge_rect(rects, count, &damage->current.rects[4*i]);
+	}
+	for(int frame=1; frame<=age; frame++)
+	{
+		const damage_frame& previous = previous_frame(damage, frame);
+		if(previous.full)
+		{
+			return false;
+		}
+		for(int i=0; i<previous.count; i++)
+		{
+			merge_rect(rects, count, &previous.rects[4*i]);
+		}
+	}
+	return true;
+}
+
+// the rects to send with the swap, 0 when the whole surface is damaged
+//------------------------------------------------------------------------------
+int damage_swap_rects(window* win, EGLint*& rects)
+{
+	damage_state* damage = win->damage;
+	const damage_frame& current = damage->current;
+	const damage_frame& previous = previous_frame(damage, 1);
+
+	rects = damage->swap_rects;
+	if(g_damageTiles)
+	{
+		return stress_tiles(win, damage->swap_rects, g_damageTiles);
+	}
+	if(current.full || previous.full || (current.count + previous.count > MAX_DAMAGE_RECTS))
+	{
+		return 0;
+	}
+
+	// what changed is this frame's rects, and last frame's to clear what
+	// moved away
+	std::copy(current.rects, current.rects + 4*current.count, damage->swap_rects);
+	std::copy(previous.rects, previous.rects + 4*previous.count, damage->swap_rects + 4*current.count);
+	int count = current.count + previous.count;
+	if(0 == count)
+	{
+		// nothing changed, an empty rect still presents the frame
+		std::fill(damage->swap_rects, damage->swap_rects + 4, 0);
+		count = 1;
+	}
+	return count;
+}
+
+// the frame was presented, it becomes the newest in the history
+//------------------------------------------------------------------------------
+void damage_end_frame(window* win)
+{
+	damage_state* damage = win->damage;
+	damage->history[damage->history_index] = damage->current;
+	damage->history_index = (damage->history_index + 1) % DAMAGE_HISTORY;
+}
@@ -0,0 +1,73 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __DAMAGE_H__
+#define __DAMAGE_H__
+
+// Damage regions
+// Each scene reports what it changed this frame, and the swap tells the
+// compositor (EGL_EXT_swap_buffers_with_damage) what changed since the
+// previous frame: this frame's rects plus last frame's, so an object that
+// moved is repainted where it was as well as where it is. The rects are in
+// window pixels with the origin in the bottom-left corner, like EGL's.
+//
+// In the stress mode the scene's damage is replaced by a number of small
+// tiles scattered over the window (g_damageTiles, params file line 25), to
+// load the compositor's damage tracking. The reported damage then no longer
+// matches what was drawn: the compositor doesn't repaint the rest of the
+// window, so what is on screen can be wrong.
+
+// more rects than this in a frame and the damage becomes the whole surface
+#define MAX_DAMAGE_RECTS	16
+
+// buffers older than this many frames are redrawn completely
+#define DAMAGE_HISTORY		4
+
+// the most rects damage_repaint_rects() returns
+#define MAX_REPAINT_RECTS	(MAX_DAMAGE_RECTS * (DAMAGE_HISTORY + 1))
+
+// start collecting the damage of a new frame
+void damage_begin(window* win);
+
+// the whole surface changed
+void damage_add_full(window* win);
+
+// the [-1,1] quad transformed by the 4x4 column major matrix 'mvp' changed
+void damage_add_quad(window* win, const float* mvp);
+
+// a rectangle in normalized device coordinates changed
+void damage_add_ndc(window* win, float x0, float y0, float x1, float y1);
+
+// partial redraw (EGL_EXT_buffer_age): the parts of the back buffer that
+// are out of date, this frame's damage and that of every frame since the
+// buffer was last drawn, with overlapping rects merged. Returns false when
+// the whole surface has to be redrawn. Call it after the frame's damage has
+// been added
+bool damage_repaint_rects(window* win, EGLint* rects, int& count);
+
+// the rects for eglSwapBuffersWithDamage, 0 when the whole surface is
+// damaged. 'rects' stays valid until the next call
+int damage_swap_rects(window* win, EGLint*& rects);
+
+// the frame was presented, keep its damage for the buffer age
+void damage_end_frame(window* win);
+
+#endif // __DAMAGE_H__
@@ -22,7 +22,7 @@
 #include "draw-digits.h"
 
 // Textures
-#include "digits.h"
+#include "assets.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -46,7 +46,41 @@ textRender::textRender()
 //------------------------------------------------------------------------------
 void textRender::InitializeDigits(window *window)
 {
-	registerTexture(g_digitTextureID, image_digits::width, image_digits::height, image_digits::header_data, 0);
+	if(0==g_digitTextureID) 
+	{
+		uploadTexture(g_digitTextureID, asset_digits_width, asset_digits_height, asset_digits_pixels);
+	}
+}
+
+// number of characters drawn for the fps, one digit after the decimal point
+//------------------------------------------------------------------------------
+static int count_digits(const std::string& buffer)
+{
+	int numDigits = 0;
+
+	for(int i=0;i<(int)buffer.length(); i++)
+	{		
+		if(buffer[i] == '.')
+		{
+			numDigits+=2;
+			break;		
+		}
+		numDigits++;
+	}
+	return numDigits;
+}
+
+// area the digits of 'fps' cover, in normalized device coordinates
+//------------------------------------------------------------------------------
+void textRender::DigitsBounds(float fps, float& x0, float& y0, float& x1, float& y1)
+{
+	std::ostringstream sstring;
+	sstring << fps;
+
+	x0 = -1.0f;
+	y0 = 1.0f - digit_height;
+	x1 = -1.0f + count_digits(sstring.str()) * (digit_width + digit_spacing);
+	y1 = 1.0f;
 }
 
 // render routine to draw the digits in upper-left
@@ -54,7 +88,6 @@ void textRender::InitializeDigits(window *window)
 void textRender::DrawDigits(float fps, void *data, struct wl_callback *callback, uint32_t time)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 
 	glUseProgram(win->gl_tex.program);
 
@@ -67,19 +100,7 @@ void textRender::DrawDigits(float fps, void *data, struct wl_callback *callback,
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, g_digitTextureID); 	
 
-	EGLint buffer_age = 0;
-
-	assert(win->callback == callback);
-	win->callback = NULL;
-
-	if (callback)
-		wl_callback_destroy(callback);
-
-	if (display->swap_buffers_with_damage)
-	{
-		eglQuerySurface(display->egl.dpy, win->egl_surface,
-				EGL_BUFFER_AGE_EXT, &buffer_age);
-	}
+	// the scene that called us already consumed the frame callback
 
 	// orthographic projection matrix	
 	float r=1.0f;
@@ -113,17 +134,7 @@ void textRender::DrawDigits(float fps, void *data, struct wl_callback *callback,
 	sstring << fps;
 	std::string buffer(sstring.str());
 
-	int numDigits = 0;
-
-	for(int i=0;i<(int)buffer.length(); i++)
-	{		
-		if(buffer[i] == '.')
-		{
-			numDigits+=2;
-			break;		
-		}
-		numDigits++;
-	}
+	int numDigits = count_digits(buffer);
 
 
 	// make a copy of the quad verts and modify those	
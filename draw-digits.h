@@ -62,6 +62,7 @@ public:
 	textRender();
 	void InitializeDigits(window *window);
 	void DrawDigits(float fps, void *data, struct wl_callback *callback, uint32_t time);	
+	void DigitsBounds(float fps, float& x0, float& y0, float& x1, float& y1);
 
 private:
 	float _last_fps;
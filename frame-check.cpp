@@ -0,0 +1,353 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+#include <map>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "main.h"
+#include "frame-check.h"
+#include "frame-queue.h"
+
+// frames waiting for the worker, more and the frames are dropped
+#define FRAME_CHECK_QUEUE_DEPTH	4
+
+// the hash eats 64 bytes per step, four 16 byte lanes, and scrambles its
+// accumulators every 1KB
+#define HASH_STRIPE			64
+#define HASH_SCRAMBLE_BYTES	1024
+#define HASH_PRIME32		0x9E3779B1u
+#define HASH_PRIME64		0x9E3779B97F4A7C15ull
+
+static const uint64_t g_hash_keys[8] = {
+	0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+	0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+};
+
+typedef std::pair<int, uint64_t> frame_key;	// surface, frame id
+
+struct frame_check {
+	frame_queue* queue;
+	FILE* golden;								// recording
+	std::map<frame_key, uint64_t> golden_hashes;	// comparing
+
+	// written by the worker only
+	uint64_t hashed, mismatches, missing;
+	uint64_t hash_sum_us;
+};
+
+static frame_check g_check;
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t mix64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// every 64 bit word multiplies its low half by its high half (after mixing
+// in the key) into its accumulator, and is added to its neighbour's
+//------------------------------------------------------------------------------
+static inline void accumulate_word(uint64_t* acc, int i, uint64_t word)
+{
+	uint64_t keyed = word ^ g_hash_keys[i];
+	acc[i ^ 1] += word;
+	acc[i] += (uint64_t)(uint32_t)keyed * (uint32_t)(keyed >> 32);
+}
+
+//------------------------------------------------------------------------------
+static inline void scramble(uint64_t* acc)
+{
+	for(int i=0; i<8; i++)
+	{
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= g_hash_keys[(i + 3) & 7];
+		acc[i] *= HASH_PRIME32;
+	}
+}
+
+#ifdef __SSE2__
+// the stripes, 16 bytes at a time; the same arithmetic as
+// accumulate_word() and scramble(), two words per register
+//------------------------------------------------------------------------------
+static void hash_stripes(uint64_t* acc, const unsigned char* data, size_t stripes)
+{
+	__m128i a[4], keys[4], scramble_keys[4];
+	for(int j=0; j<4; j++)
+	{
+		a[j] = _mm_loadu_si128((const __m128i*)(acc + 2*j));
+		keys[j] = _mm_loadu_si128((const __m128i*)(g_hash_keys + 2*j));
+		scramble_keys[j] = _mm_set_epi64x((long long)g_hash_keys[(2*j + 4) & 7], (long long)g_hash_keys[(2*j + 3) & 7]);
+	}
+	const __m128i prime = _mm_set1_epi32((int)HASH_PRIME32);
+
+	for(size_t s=0; s<stripes; s++, data += HASH_STRIPE)
+	{
+		for(int j=0; j<4; j++)
+		{
+			__m128i word = _mm_loadu_si128((const __m128i*)(data + 16*j));
+			__m128i keyed = _mm_xor_si128(word, keys[j]);
+			__m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(2, 3, 0, 1)));
+			a[j] = _mm_add_epi64(a[j], _mm_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2)));
+			a[j] = _mm_add_epi64(a[j], product);
+		}
+
+		if(0 == ((s + 1) % (HASH_SCRAMBLE_BYTES / HASH_STRIPE)))
+		{
+			for(int j=0; j<4; j++)
+			{
+				__m128i v = _mm_xor_si128(a[j], _mm_srli_epi64(a[j], 47));
+				v = _mm_xor_si128(v, scramble_keys[j]);
+				__m128i low = _mm_mul_epu32(v, prime);
+				__m128i high = _mm_mul_epu32(_mm_srli_epi64(v, 32), prime);
+				a[j] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+			}
+		}
+	}
+
+	for(int j=0; j<4; j++)
+	{
+		_mm_storeu_si128((__m128i*)(acc + 2*j), a[j]);
+	}
+}
+#else
+//------------------------------------------------------------------------------
+static void hash_stripes(uint64_t* acc, const unsigned char* data, size_t stripes)
+{
+	for(size_t s=0; s<stripes; s++, data += HASH_STRIPE)
+	{
+		for(int i=0; i<8; i++)
+		{
+			uint64_t word;
+			memcpy(&word, data + 8*i, sizeof(word));
+			accumulate_word(acc, i, word);
+		}
+		if(0 == ((s + 1) % (HASH_SCRAMBLE_BYTES / HASH_STRIPE)))
+		{
+			scramble(acc);
+		}
+	}
+}
+#endif
+
+// 64 bit hash of 'size' bytes, SSE2 when the compiler targets it, the same
+// value either way
+//------------------------------------------------------------------------------
+uint64_t frame_hash(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t acc[8];
+	for(int i=0; i<8; i++)
+	{
+		acc[i] = g_hash_keys[i] ^ seed;
+	}
+
+	size_t stripes = size / HASH_STRIPE;
+	hash_stripes(acc, bytes, stripes);
+	bytes += stripes * HASH_STRIPE;
+	size -= stripes * HASH_STRIPE;
+
+	// the last words, zero padded
+	for(int i=0; size; i++)
+	{
+		uint64_t word = 0;
+		size_t count = (size < sizeof(word)) ? size : sizeof(word);
+		memcpy(&word, bytes, count);
+		accumulate_word(acc, i, word);
+		bytes += count;
+		size -= count;
+	}
+
+	uint64_t h = (uint64_t)(stripes * HASH_STRIPE) * HASH_PRIME64 ^ seed;
+	for(int i=0; i<8; i++)
+	{
+		h = (h ^ mix64(acc[i])) * HASH_PRIME64;
+	}
+	return mix64(h);
+}
+
+// the worker: hash the frame and record or compare it
+//------------------------------------------------------------------------------
+static void check_frame(const queued_frame& frame, void* data)
+{
+	uint64_t start = monotonic_now_us();
+	uint64_t seed = ((uint64_t)frame.width << 32) | (uint32_t)frame.height;
+	uint64_t hash = frame_hash(frame.pixels, frame.size, seed);
+	g_check.hash_sum_us += monotonic_now_us() - start;
+	g_check.hashed++;
+
+	if(frameCheckRecord == g_frameCheckMode)
+	{
+		// written as they come, so a run that dies still leaves its hashes
+		fprintf(g_check.golden, "%d %llu %016llx\n", frame.surface_index, (unsigned long long)frame.frame_id, (unsigned long long)hash);
+		fflush(g_check.golden);
+		return;
+	}
+
+	std::map<frame_key, uint64_t>::const_iterator golden = g_check.golden_hashes.find(frame_key(frame.surface_index, frame.frame_id));
+	if(golden == g_check.golden_hashes.end())
+	{
+		g_check.missing++;
+	}
+	else if(golden->second != hash)
+	{
+		g_check.mismatches++;
+		printf("Frame check: surface %d frame %llu hash %016llx, golden %016llx, MISMATCH\n",
+			frame.surface_index, (unsigned long long)frame.frame_id,
+			(unsigned long long)hash, (unsigned long long)golden->second);
+		fflush(stdout);
+	}
+}
+
+//------------------------------------------------------------------------------
+static void load_golden_file(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+	if(!file)
+	{
+		printf("Frame check: can't read the golden file %s\n", filename);
+		exit(1);
+	}
+
+	char line[256];
+	while(fgets(line, sizeof(line), file))
+	{
+		int surface;
+		unsigned long long frame_id, hash;
+		if(('#' != line[0]) && (3 == sscanf(line, "%d %llu %llx", &surface, &frame_id, &hash)))
+		{
+			g_check.golden_hashes[frame_key(surface, frame_id)] = hash;
+		}
+	}
+	fclose(file);
+	printf("Frame check: comparing against %u hashes from %s\n", (unsigned int)g_check.golden_hashes.size(), filename);
+}
+
+// open or load the golden file and start the worker, exits when a golden
+// file to compare against can't be read
+//------------------------------------------------------------------------------
+void frame_check_start(const char* golden_filename)
+{
+	if(!frame_check_enabled())
+	{
+		return;
+	}
+
+	if(0 == g_fixedTimestep)
+	{
+		printf("Frame check without a fixed timestep (21), the frames won't match from run to run\n");
+	}
+
+	if(frameCheckRecord == g_frameCheckMode)
+	{
+		g_check.golden = fopen(golden_filename, "w");
+		if(!g_check.golden)
+		{
+			printf("Frame check: can't write the golden file %s\n", golden_filename);
+			exit(1);
+		}
+		fprintf(g_check.golden, "# stress-weston golden frames, every %u frames\n# surface frame hash\n", g_frameCheckInterval);
+		printf("Frame check: recording every %u frames to %s\n", g_frameCheckInterval, golden_filename);
+	}
+	else
+	{
+		load_golden_file(golden_filename);
+	}
+
+	g_check.queue = frame_queue_start("Frame check", FRAME_CHECK_QUEUE_DEPTH, check_frame, NULL);
+}
+
+//------------------------------------------------------------------------------
+bool frame_check_enabled()
+{
+	return (frameCheckRecord == g_frameCheckMode) || (frameCheckCompare == g_frameCheckMode);
+}
+
+// this frame of the surface gets hashed
+//------------------------------------------------------------------------------
+bool frame_check_wanted(const window* win)
+{
+	return g_check.queue && (0 == (win->frame_id % g_frameCheckInterval));
+}
+
+// where the frame's pixels are read to, NULL when the worker is behind and
+// the frame can't be checked
+//------------------------------------------------------------------------------
+unsigned char* frame_check_buffer(size_t size)
+{
+	return g_check.queue ? frame_queue_acquire(g_check.queue, size) : NULL;
+}
+
+// hash the frame in a buffer from frame_check_buffer()
+//------------------------------------------------------------------------------
+void frame_check_submit(const window* win, uint64_t frame_id, unsigned char* pixels,
+						int width, int height, int bytes_per_pixel)
+{
+	frame_queue_submit(g_check.queue, pixels, win->surface_index, frame_id, width, height, bytes_per_pixel);
+}
+
+// wait for the frames that were submitted, print the result and close the
+// golden file
+//------------------------------------------------------------------------------
+void frame_check_stop()
+{
+	if(!g_check.queue)
+	{
+		return;
+	}
+	frame_queue_stop(g_check.queue);
+	g_check.queue = NULL;
+
+	printf("Frame check: %llu frames hashed, %.3f ms each on the worker",
+		(unsigned long long)g_check.hashed,
+		g_check.hashed ? (double)g_check.hash_sum_us / g_check.hashed / 1000.0 : 0.0);
+	if(frameCheckCompare == g_frameCheckMode)
+	{
+		printf(", %llu mismatches, %llu not in the golden file",
+			(unsigned long long)g_check.mismatches, (unsigned long long)g_check.missing);
+	}
+	printf("\n");
+
+	if(g_check.golden)
+	{
+		fclose(g_check.golden);
+		g_check.golden = NULL;
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __FRAME_CHECK_H__
+#define __FRAME_CHECK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame check
+// Tells whether frames render correctly, not just how fast, for preemption
+// and GPU reset testing. Every g_frameCheckInterval-th frame (params file
+// line 46) is read back (see readback.h) and hashed on a worker thread (see
+// frame-queue.h). Recording (line 45 = 1) writes the hashes to the golden
+// file, comparing (2) looks each hash up in it and logs the frames that
+// don't match. The frames only match from run to run with a fixed timestep
+// (line 21).
+enum FrameCheckModes {
+	frameCheckOff = 0,
+	frameCheckRecord,
+	frameCheckCompare,
+	frameCheckModeCount,
+};
+
+// open or load the golden file and start the worker, exits when a golden
+// file to compare against can't be read
+void frame_check_start(const char* golden_filename);
+
+bool frame_check_enabled();
+
+// this frame of the surface gets hashed
+bool frame_check_wanted(const window* win);
+
+// where the frame's pixels are read to, NULL when the worker is behind and
+// the frame can't be checked
+unsigned char* frame_check_buffer(size_t size);
+
+// hash the frame in a buffer from frame_check_buffer()
+void frame_check_submit(const window* win, uint64_t frame_id, unsigned char* pixels,
+						int width, int height, int bytes_per_pixel);
+
+// wait for the frames that were submitted, print the result and close the
+// golden file
+void frame_check_stop();
+
+// 64 bit hash of 'size' bytes, SSE2 when the compiler targets it, the same
+// value either way
+uint64_t frame_hash(const void* data, size_t size, uint64_t seed);
+
+#endif // __FRAME_CHECK_H__
@@ -0,0 +1,213 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+#include "frame-queue.h"
+
+#define MAX_QUEUED_FRAMES	16
+
+struct frame_queue {
+	const char* name;
+	frame_consumer consumer;
+	void* data;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t ready_cond;
+	bool stopping;
+
+	// the buffers, either free, filled by a render thread or waiting for
+	// (or being used by) the worker
+	queued_frame frames[MAX_QUEUED_FRAMES];
+	size_t capacity[MAX_QUEUED_FRAMES];
+	int depth;
+	std::vector<int> free_frames;
+	std::deque<int> ready_frames;
+
+	uint64_t submitted, dropped;
+};
+
+//------------------------------------------------------------------------------
+static void* frame_queue_worker(void* data)
+{
+	frame_queue* queue = (frame_queue*)data;
+
+	pthread_mutex_lock(&queue->lock);
+	for(;;)
+	{
+		while(queue->ready_frames.empty() && !queue->stopping)
+		{
+			pthread_cond_wait(&queue->ready_cond, &queue->lock);
+		}
+		if(queue->ready_frames.empty())
+		{
+			break;
+		}
+		int index = queue->ready_frames.front();
+		queue->ready_frames.pop_front();
+		pthread_mutex_unlock(&queue->lock);
+
+		queue->consumer(queue->frames[index], queue->data);
+
+		pthread_mutex_lock(&queue->lock);
+		queue->free_frames.push_back(index);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return NULL;
+}
+
+// start a worker with 'depth' buffers
+//------------------------------------------------------------------------------
+frame_queue* frame_queue_start(const char* name, int depth, frame_consumer consumer, void* data)
+{
+	frame_queue* queue = new frame_queue;
+	queue->name = name;
+	queue->consumer = consumer;
+	queue->data = data;
+	queue->stopping = false;
+	queue->submitted = 0;
+	queue->dropped = 0;
+
+	queue->depth = (depth < 1) ? 1 : ((depth > MAX_QUEUED_FRAMES) ? MAX_QUEUED_FRAMES : depth);
+	for(int i=0; i<queue->depth; i++)
+	{
+		queue->frames[i].pixels = NULL;
+		queue->capacity[i] = 0;
+		queue->free_frames.push_back(i);
+	}
+
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->ready_cond, NULL);
+	if(pthread_create(&queue->thread, NULL, frame_queue_worker, queue))
+	{
+		printf("%s: could not start the worker thread\n", name);
+		exit(1);
+	}
+	return queue;
+}
+
+// a free buffer of at least 'size' bytes, NULL when the worker is behind
+// and the frame has to be dropped
+//------------------------------------------------------------------------------
+unsigned char* frame_queue_acquire(frame_queue* queue, size_t size)
+{
+	pthread_mutex_lock(&queue->lock);
+	if(queue->free_frames.empty())
+	{
+		queue->dropped++;
+		pthread_mutex_unlock(&queue->lock);
+		return NULL;
+	}
+	int index = queue->free_frames.back();
+	queue->free_frames.pop_back();
+
+	// the buffer belongs to the caller until it is submitted, but another
+	// render thread's submit looks its pointer up, so it only changes under
+	// the lock. It only grows, which happens on the first frames
+	queued_frame& frame = queue->frames[index];
+	if(size > queue->capacity[index])
+	{
+		delete[] frame.pixels;
+		frame.pixels = new unsigned char[size];
+		queue->capacity[index] = size;
+	}
+	frame.size = size;
+	unsigned char* pixels = frame.pixels;
+	pthread_mutex_unlock(&queue->lock);
+	return pixels;
+}
+
+// hand a buffer from frame_queue_acquire() with a frame in it to the worker
+//------------------------------------------------------------------------------
+void frame_queue_submit(frame_queue* queue, unsigned char* pixels, int surface_index, uint64_t frame_id,
+						int width, int height, int bytes_per_pixel)
+{
+	// the pointers of the other threads' buffers can change, see above
+	pthread_mutex_lock(&queue->lock);
+	int index = 0;
+	while((index < queue->depth) && (queue->frames[index].pixels != pixels))
+	{
+		index++;
+	}
+	if(index == queue->depth)
+	{
+		pthread_mutex_unlock(&queue->lock);
+		printf("%s: submitted a buffer that isn't the queue's\n", queue->name);
+		return;
+	}
+
+	queued_frame& frame = queue->frames[index];
+	frame.surface_index = surface_index;
+	frame.frame_id = frame_id;
+	frame.width = width;
+	frame.height = height;
+	frame.bytes_per_pixel = bytes_per_pixel;
+
+	queue->ready_frames.push_back(index);
+	queue->submitted++;
+	pthread_cond_signal(&queue->ready_cond);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+// frames that were dropped so far because the worker was behind
+//------------------------------------------------------------------------------
+uint64_t frame_queue_dropped(frame_queue* queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	uint64_t dropped = queue->dropped;
+	pthread_mutex_unlock(&queue->lock);
+	return dropped;
+}
+
+// let the worker finish the frames it has, stop it and free the buffers
+//------------------------------------------------------------------------------
+void frame_queue_stop(frame_queue* queue)
+{
+	if(!queue)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&queue->lock);
+	queue->stopping = true;
+	pthread_cond_signal(&queue->ready_cond);
+	pthread_mutex_unlock(&queue->lock);
+	pthread_join(queue->thread, NULL);
+
+	if(queue->dropped)
+	{
+		printf("%s: %llu frames, %llu dropped because the worker was behind\n", queue->name,
+			(unsigned long long)queue->submitted, (unsigned long long)queue->dropped);
+	}
+
+	for(int i=0; i<queue->depth; i++)
+	{
+		delete[] queue->frames[i].pixels;
+	}
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->ready_cond);
+	delete queue;
+}
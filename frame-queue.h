@@ -0,0 +1,66 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __FRAME_QUEUE_H__
+#define __FRAME_QUEUE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame queue
+// Hands frames that were read back to a worker thread, so whatever is done
+// with them (hashing, writing them out) stays off the render threads. The
+// queue owns a fixed number of buffers; a render thread copies a frame into
+// a free one and submits it, the worker gives it back when it is done. When
+// the worker falls behind there is no free buffer and the frame is dropped,
+// the render thread never waits for it.
+struct queued_frame {
+	int surface_index;
+	uint64_t frame_id;
+	int width, height;
+	int bytes_per_pixel;
+	unsigned char* pixels;
+	size_t size;
+};
+
+// called on the worker thread for every submitted frame, in order
+typedef void (*frame_consumer)(const queued_frame& frame, void* data);
+
+struct frame_queue;
+
+// start a worker with 'depth' buffers
+frame_queue* frame_queue_start(const char* name, int depth, frame_consumer consumer, void* data);
+
+// a free buffer of at least 'size' bytes, NULL when the worker is behind
+// and the frame has to be dropped
+unsigned char* frame_queue_acquire(frame_queue* queue, size_t size);
+
+// hand a buffer from frame_queue_acquire() with a frame in it to the worker
+void frame_queue_submit(frame_queue* queue, unsigned char* pixels, int surface_index, uint64_t frame_id,
+						int width, int height, int bytes_per_pixel);
+
+// frames that were dropped so far because the worker was behind
+uint64_t frame_queue_dropped(frame_queue* queue);
+
+// let the worker finish the frames it has, stop it and free the buffers
+void frame_queue_stop(frame_queue* queue);
+
+#endif // __FRAME_QUEUE_H__
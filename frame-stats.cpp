@@ -0,0 +1,322 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "frame-stats.h"
+
+// frame times are strongly correlated with their neighbours, so the
+// confidence interval of the mean is computed from the means of blocks of
+// frames (batch means) rather than from the individual frames
+#define BLOCK_SIZE 32
+
+// warm-up is over once this many consecutive block means agree
+#define WARMUP_BLOCKS 4
+
+// the p99 confidence interval needs a reasonable number of samples
+#define MIN_MEASURED_FRAMES 256
+
+// two-sided 95% student-t values for 1..30 degrees of freedom
+static const double t_table[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+//------------------------------------------------------------------------------
+static double t_value(unsigned int degrees_of_freedom)
+{
+	if(0 == degrees_of_freedom)
+	{
+		return t_table[0];
+	}
+	if(degrees_of_freedom <= 30)
+	{
+		return t_table[degrees_of_freedom-1];
+	}
+	return 1.96;
+}
+
+// value at rank 'index' of the sorted samples, without a full sort
+//------------------------------------------------------------------------------
+static double rank_value(std::vector<uint32_t>& scratch, long index)
+{
+	if(index < 0)
+	{
+		index = 0;
+	}
+	if(index >= (long)scratch.size())
+	{
+		index = scratch.size() - 1;
+	}
+	std::nth_element(scratch.begin(), scratch.begin() + index, scratch.end());
+	return scratch[index];
+}
+
+//------------------------------------------------------------------------------
+bool summarize_frame_times(std::vector<uint32_t>& scratch, frame_summary& summary)
+{
+	const size_t n = scratch.size();
+	if(n < 2)
+	{
+		return false;
+	}
+
+	summary.count = n;
+
+	// mean, and the spread of the block means
+	double sum = 0.0;
+	for(size_t i=0; i<n; i++)
+	{
+		sum += scratch[i];
+	}
+	summary.mean = sum / n;
+
+	unsigned int blocks = n / BLOCK_SIZE;
+	if(blocks >= 2)
+	{
+		double block_var = 0.0;
+		for(unsigned int b=0; b<blocks; b++)
+		{
+			double block_sum = 0.0;
+			for(unsigned int i=0; i<BLOCK_SIZE; i++)
+			{
+				block_sum += scratch[b*BLOCK_SIZE + i];
+			}
+			double diff = block_sum / BLOCK_SIZE - summary.mean;
+			block_var += diff * diff;
+		}
+		block_var /= (blocks - 1);
+		summary.mean_ci = t_value(blocks - 1) * sqrt(block_var / blocks);
+	}
+	else
+	{
+		summary.mean_ci = summary.mean;
+	}
+
+	// order statistics - the confidence interval of a quantile q comes from
+	// the binomial distribution of the number of samples below it
+	const double q = 0.99;
+	const double spread = 1.96 * sqrt(n * q * (1.0 - q));
+
+	summary.median = rank_value(scratch, n / 2);
+	summary.p99 = rank_value(scratch, (long)(n * q));
+	summary.p99_ci_low = rank_value(scratch, (long)floor(n * q - spread));
+	summary.p99_ci_high = rank_value(scratch, (long)ceil(n * q + spread));
+
+	return true;
+}
+
+
+// adaptive run state
+enum adaptive_phase {
+	adaptive_off,
+	adaptive_warmup,
+	adaptive_measure,
+	adaptive_done,
+};
+
+static struct {
+	adaptive_phase phase;
+	double tolerance;
+	uint64_t max_duration_us;
+	uint64_t elapsed_us;
+
+	// warm-up
+	uint64_t block_sum;
+	uint32_t block_frames;
+	double block_means[WARMUP_BLOCKS];
+	uint32_t block_count;
+	uint32_t warmup_frames;
+	uint64_t warmup_us;
+
+	// measurement
+	std::vector<uint32_t> samples;
+	std::vector<uint32_t> scratch;
+	size_t next_check;
+	bool converged;
+	frame_summary summary;
+} g_adaptive;
+
+//------------------------------------------------------------------------------
+void adaptive_run_configure(unsigned int tolerance, unsigned int max_seconds)
+{
+	g_adaptive.phase = tolerance ? adaptive_warmup : adaptive_off;
+	g_adaptive.tolerance = tolerance / 1000.0;
+	g_adaptive.max_duration_us = max_seconds * 1000000ull;
+	g_adaptive.elapsed_us = 0;
+
+	g_adaptive.block_sum = 0;
+	g_adaptive.block_frames = 0;
+	g_adaptive.block_count = 0;
+	g_adaptive.warmup_frames = 0;
+	g_adaptive.warmup_us = 0;
+
+	g_adaptive.samples.clear();
+	g_adaptive.next_check = MIN_MEASURED_FRAMES;
+	g_adaptive.converged = false;
+	g_adaptive.summary = frame_summary();
+
+	if(tolerance)
+	{
+		printf("Adaptive run: waiting for frame times to settle (tolerance %.1f%%, at most %u seconds)\n", tolerance / 10.0, max_seconds);
+	}
+}
+
+// warm-up detection - returns true once the last few block means are 
+// within twice the tolerance of each other
+//------------------------------------------------------------------------------
+static bool warmup_frame(uint32_t frame_time_us)
+{
+	g_adaptive.block_sum += frame_time_us;
+	g_adaptive.block_frames++;
+	g_adaptive.warmup_frames++;
+	g_adaptive.warmup_us += frame_time_us;
+
+	if(g_adaptive.block_frames < BLOCK_SIZE)
+	{
+		return false;
+	}
+
+	g_adaptive.block_means[g_adaptive.block_count % WARMUP_BLOCKS] = (double)g_adaptive.block_sum / BLOCK_SIZE;
+	g_adaptive.block_count++;
+	g_adaptive.block_sum = 0;
+	g_adaptive.block_frames = 0;
+
+	if(g_adaptive.block_count < WARMUP_BLOCKS)
+	{
+		return false;
+	}
+
+	double lowest = g_adaptive.block_means[0];
+	double highest = g_adaptive.block_means[0];
+	double sum = 0.0;
+	for(int i=0; i<WARMUP_BLOCKS; i++)
+	{
+		lowest = std::min(lowest, g_adaptive.block_means[i]);
+		highest = std::max(highest, g_adaptive.block_means[i]);
+		sum += g_adaptive.block_means[i];
+	}
+
+	return (highest - lowest) <= 2.0 * g_adaptive.tolerance * (sum / WARMUP_BLOCKS);
+}
+
+// both confidence intervals narrower than the tolerance?
+//------------------------------------------------------------------------------
+static bool check_convergence()
+{
+	g_adaptive.scratch = g_adaptive.samples;
+	if(!summarize_frame_times(g_adaptive.scratch, g_adaptive.summary))
+	{
+		return false;
+	}
+
+	const frame_summary& s = g_adaptive.summary;
+	bool mean_ok = s.mean_ci <= g_adaptive.tolerance * s.mean;
+	bool p99_ok = (s.p99_ci_high - s.p99_ci_low) <= 2.0 * g_adaptive.tolerance * s.p99;
+
+	return mean_ok && p99_ok;
+}
+
+//------------------------------------------------------------------------------
+static void print_adaptive_summary()
+{
+	const frame_summary& s = g_adaptive.summary;
+
+	printf("Adaptive run: warm-up of %u frames (%.2f s) excluded\n", 
+		g_adaptive.warmup_frames, g_adaptive.warmup_us / 1000000.0);
+	printf("Adaptive run: %s after %u measured frames (%.2f s)\n",
+		g_adaptive.converged ? "converged" : "NOT converged, hit the maximum duration",
+		s.count, (g_adaptive.elapsed_us - g_adaptive.warmup_us) / 1000000.0);
+	printf("Adaptive run: mean %.3f ms +/- %.3f ms, median %.3f ms, p99 %.3f ms [%.3f, %.3f]\n",
+		s.mean / 1000.0, s.mean_ci / 1000.0, s.median / 1000.0, 
+		s.p99 / 1000.0, s.p99_ci_low / 1000.0, s.p99_ci_high / 1000.0);
+}
+
+//------------------------------------------------------------------------------
+bool adaptive_run_frame(uint32_t frame_time_us)
+{
+	// the very first frame has no previous frame to measure against
+	if((adaptive_off == g_adaptive.phase) || (0 == frame_time_us))
+	{
+		return false;
+	}
+
+	if(adaptive_done == g_adaptive.phase)
+	{
+		return true;
+	}
+
+	g_adaptive.elapsed_us += frame_time_us;
+	bool timed_out = g_adaptive.max_duration_us && (g_adaptive.elapsed_us >= g_adaptive.max_duration_us);
+
+	if(adaptive_warmup == g_adaptive.phase)
+	{
+		// if the frame times never settle, give up on warm-up detection 
+		// after a third of the time budget and measure what is there
+		bool settled = warmup_frame(frame_time_us);
+		bool giving_up = g_adaptive.max_duration_us && (g_adaptive.elapsed_us * 3 >= g_adaptive.max_duration_us);
+
+		if(settled || giving_up)
+		{
+			if(!settled)
+			{
+				printf("Adaptive run: frame times did not settle, measuring anyway\n");
+			}
+			g_adaptive.phase = adaptive_measure;
+			g_adaptive.samples.reserve(4096);
+		}
+		return false;
+	}
+
+	g_adaptive.samples.push_back(frame_time_us);
+
+	// re-check at geometrically spaced sample counts, keeping the total
+	// analysis cost linear in the number of frames
+	if((g_adaptive.samples.size() >= g_adaptive.next_check) || timed_out)
+	{
+		g_adaptive.converged = check_convergence();
+		g_adaptive.next_check = g_adaptive.samples.size() + std::max((size_t)BLOCK_SIZE, g_adaptive.samples.size() / 4);
+
+		if(g_adaptive.converged || timed_out)
+		{
+			g_adaptive.phase = adaptive_done;
+			print_adaptive_summary();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+bool adaptive_run_converged()
+{
+	return g_adaptive.converged;
+}
+
+//------------------------------------------------------------------------------
+const frame_summary& adaptive_run_summary()
+{
+	return g_adaptive.summary;
+}
@@ -0,0 +1,57 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __FRAME_STATS_H__
+#define __FRAME_STATS_H__
+
+#include <stdint.h>
+#include <vector>
+
+// summary of a set of frame times, all times in microseconds
+struct frame_summary {
+	uint32_t count;
+	double mean;
+	double mean_ci;			// half-width of the 95% confidence interval of the mean
+	double median;
+	double p99;
+	double p99_ci_low;		// 95% confidence interval of the p99
+	double p99_ci_high;
+};
+
+// summarize frame times, 'scratch' is reordered
+bool summarize_frame_times(std::vector<uint32_t>& scratch, frame_summary& summary);
+
+// Adaptive run length
+// Frames are dropped until the frame times have settled (warm-up), then
+// measured until the 95% confidence intervals of both the mean and the p99
+// are within the tolerance, or the maximum duration is reached.
+
+// (re)start an adaptive run, tolerance is in 0.1% units, 0 disables it
+void adaptive_run_configure(unsigned int tolerance, unsigned int max_seconds);
+
+// feed one frame time, returns true once the run is complete
+bool adaptive_run_frame(uint32_t frame_time_us);
+
+// results of the last completed adaptive run
+bool adaptive_run_converged();
+const frame_summary& adaptive_run_summary();
+
+#endif // __FRAME_STATS_H__
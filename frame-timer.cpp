@@ -0,0 +1,159 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+
+#include "frame-timer.h"
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static struct timespec to_timespec(uint64_t ns)
+{
+	struct timespec ts;
+	ts.tv_sec = ns / 1000000000ull;
+	ts.tv_nsec = ns % 1000000000ull;
+	return ts;
+}
+
+// arm the timer, the first deadline is at least one period away
+//------------------------------------------------------------------------------
+bool frame_timer_start(frame_timer& timer, uint32_t period_us, uint32_t phase_us)
+{
+	memset(&timer, 0, sizeof(timer));
+	timer.fd = -1;
+	if(0 == period_us)
+	{
+		printf("Frame timer period can't be 0\n");
+		return false;
+	}
+
+	timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if(timer.fd < 0)
+	{
+		printf("Could not create the frame timer: %s\n", strerror(errno));
+		return false;
+	}
+
+	// deadlines sit on the period grid of the monotonic clock, shifted by
+	// the phase, so they don't depend on when the app was started
+	timer.period_ns = (uint64_t)period_us * 1000;
+	uint64_t phase_ns = ((uint64_t)phase_us * 1000) % timer.period_ns;
+	uint64_t now = monotonic_now_ns();
+	uint64_t first = (now / timer.period_ns + 1) * timer.period_ns + phase_ns;
+	if(first < now + timer.period_ns)
+	{
+		first += timer.period_ns;
+	}
+	timer.deadline_ns = first - timer.period_ns;
+
+	struct itimerspec spec;
+	spec.it_value = to_timespec(first);
+	spec.it_interval = to_timespec(timer.period_ns);
+	if(timerfd_settime(timer.fd, TFD_TIMER_ABSTIME, &spec, NULL))
+	{
+		printf("Could not arm the frame timer: %s\n", strerror(errno));
+		close(timer.fd);
+		timer.fd = -1;
+		return false;
+	}
+	return true;
+}
+
+// wait at most timeout_ms for the next deadline, returns true when a frame
+// is due
+//------------------------------------------------------------------------------
+bool frame_timer_wait(frame_timer& timer, int timeout_ms)
+{
+	struct pollfd pfd;
+	pfd.fd = timer.fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if(poll(&pfd, 1, timeout_ms) <= 0)
+	{
+		return false;
+	}
+
+	// the number of deadlines since the last read, more than one means the
+	// previous frame ran past a deadline
+	uint64_t expirations = 0;
+	if((read(timer.fd, &expirations, sizeof(expirations)) != sizeof(expirations)) || (0 == expirations))
+	{
+		return false;
+	}
+	timer.deadline_ns += expirations * timer.period_ns;
+	timer.missed += expirations - 1;
+
+	uint32_t lateness = frame_timer_lateness_us(timer);
+	timer.frames++;
+	timer.lateness_sum_us += lateness;
+	if(lateness > timer.lateness_max_us)
+	{
+		timer.lateness_max_us = lateness;
+	}
+	return true;
+}
+
+// time since the deadline of the current frame
+//------------------------------------------------------------------------------
+uint32_t frame_timer_lateness_us(const frame_timer& timer)
+{
+	uint64_t now = monotonic_now_ns();
+	if(now < timer.deadline_ns)
+	{
+		return 0;
+	}
+	return (uint32_t)((now - timer.deadline_ns) / 1000);
+}
+
+// print the lateness stats and close the timer
+//------------------------------------------------------------------------------
+void frame_timer_stop(frame_timer& timer, int surface_index)
+{
+	if(timer.fd < 0)
+	{
+		return;
+	}
+	close(timer.fd);
+	timer.fd = -1;
+
+	if(surface_index)
+	{
+		printf("[surface %d] ", surface_index);
+	}
+	printf("Frame timer: %llu frames, start lateness mean %.1f us, max %u us, %llu deadlines missed\n",
+		(unsigned long long)timer.frames,
+		timer.frames ? (double)timer.lateness_sum_us / timer.frames : 0.0,
+		timer.lateness_max_us,
+		(unsigned long long)timer.missed);
+}
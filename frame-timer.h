@@ -0,0 +1,57 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __FRAME_TIMER_H__
+#define __FRAME_TIMER_H__
+
+#include <stdint.h>
+
+// Fixed-rate frame timer
+// Frame starts are driven by a timerfd on CLOCK_MONOTONIC. The deadlines are
+// absolute, first deadline + N periods, so a late frame never shifts the ones
+// after it. The phase offsets the deadlines from the period grid, so two
+// instances with the same period start their frames at a fixed distance.
+struct frame_timer {
+	int fd;
+	uint64_t period_ns;
+	uint64_t deadline_ns;		// the most recent deadline that expired
+
+	// how late the frame starts were, in microseconds
+	uint64_t frames;
+	uint64_t missed;			// deadlines that passed without a frame
+	uint64_t lateness_sum_us;
+	uint32_t lateness_max_us;
+};
+
+// arm the timer, the first deadline is at least one period away
+bool frame_timer_start(frame_timer& timer, uint32_t period_us, uint32_t phase_us);
+
+// wait at most timeout_ms for the next deadline, returns true when a frame
+// is due
+bool frame_timer_wait(frame_timer& timer, int timeout_ms);
+
+// time since the deadline of the current frame
+uint32_t frame_timer_lateness_us(const frame_timer& timer);
+
+// print the lateness stats and close the timer
+void frame_timer_stop(frame_timer& timer, int surface_index);
+
+#endif // __FRAME_TIMER_H__
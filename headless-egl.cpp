@@ -0,0 +1,196 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "main.h"
+#include "headless-egl.h"
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+#ifndef EGL_PLATFORM_DEVICE_EXT
+#define EGL_PLATFORM_DEVICE_EXT 0x313F
+#endif
+
+#ifndef EGL_EXT_device_base
+typedef void* EGLDeviceEXT;
+typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDEVICESEXTPROC) (EGLint max_devices, EGLDeviceEXT *devices, EGLint *num_devices);
+#endif
+
+#ifndef EGL_EXT_platform_base
+typedef EGLDisplay (EGLAPIENTRYP PFNEGLGETPLATFORMDISPLAYEXTPROC) (EGLenum platform, void *native_display, const EGLint *attrib_list);
+#endif
+
+#define MAX_EGL_DEVICES 16
+
+//------------------------------------------------------------------------------
+static bool has_extension(const char* extensions, const char* name)
+{
+	return extensions && strstr(extensions, name);
+}
+
+// the surfaceless platform is preferred, it needs no device enumeration and
+// works with llvmpipe; the device platform covers the proprietary drivers
+//------------------------------------------------------------------------------
+static EGLDisplay get_headless_display()
+{
+	const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if(!get_platform_display)
+	{
+		printf("Headless: eglGetPlatformDisplayEXT is not supported\n");
+		return EGL_NO_DISPLAY;
+	}
+
+	if(has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+	{
+		EGLDisplay dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if(EGL_NO_DISPLAY != dpy)
+		{
+			printf("Headless: using EGL_MESA_platform_surfaceless\n");
+			return dpy;
+		}
+	}
+
+	if(has_extension(client_extensions, "EGL_EXT_platform_device"))
+	{
+		PFNEGLQUERYDEVICESEXTPROC query_devices =
+			(PFNEGLQUERYDEVICESEXTPROC) eglGetProcAddress("eglQueryDevicesEXT");
+		EGLDeviceEXT devices[MAX_EGL_DEVICES];
+		EGLint count = 0;
+
+		if(query_devices && query_devices(MAX_EGL_DEVICES, devices, &count) && count > 0)
+		{
+			EGLDisplay dpy = get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[0], NULL);
+			if(EGL_NO_DISPLAY != dpy)
+			{
+				printf("Headless: using EGL_EXT_platform_device (%d devices)\n", count);
+				return dpy;
+			}
+		}
+	}
+
+	return EGL_NO_DISPLAY;
+}
+
+//------------------------------------------------------------------------------
+void init_headless_egl(display* display, window* window)
+{
+	EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+
+	static const EGLint pbuffer_attribs[] = {
+		EGL_WIDTH, 1,
+		EGL_HEIGHT, 1,
+		EGL_NONE
+	};
+
+	EGLint major, minor, n = 0;
+
+	display->egl.dpy = get_headless_display();
+	if(EGL_NO_DISPLAY == display->egl.dpy)
+	{
+		printf("Headless: no surfaceless or device EGL platform available\n");
+		exit(1);
+	}
+
+	if(!eglInitialize(display->egl.dpy, &major, &minor) || !eglBindAPI(EGL_OPENGL_ES_API))
+	{
+		printf("Headless: eglInitialize() failed 0x%x\n", eglGetError());
+		exit(1);
+	}
+	printf("Headless: EGL %d.%d, %s\n", major, minor, eglQueryString(display->egl.dpy, EGL_VENDOR));
+
+	const char* extensions = eglQueryString(display->egl.dpy, EGL_EXTENSIONS);
+	bool surfaceless = has_extension(extensions, "EGL_KHR_surfaceless_context");
+
+	// a surfaceless context doesn't need a pbuffer capable config
+	if(!eglChooseConfig(display->egl.dpy, config_attribs, &display->egl.conf, 1, &n) || n < 1)
+	{
+		config_attribs[1] = 0;
+		if(!surfaceless || !eglChooseConfig(display->egl.dpy, config_attribs, &display->egl.conf, 1, &n) || n < 1)
+		{
+			printf("Headless: no usable EGL config\n");
+			exit(1);
+		}
+	}
+
+	display->egl.ctx = create_gles_context(display, EGL_NO_CONTEXT);
+	if(EGL_NO_CONTEXT == display->egl.ctx)
+	{
+		printf("Headless: eglCreateContext() failed 0x%x\n", eglGetError());
+		exit(1);
+	}
+
+	// the scenes always render into the offscreen framebuffer object, the
+	// surface is only there to bind the context to
+	window->egl_surface = EGL_NO_SURFACE;
+	if(!surfaceless)
+	{
+		window->egl_surface = eglCreatePbufferSurface(display->egl.dpy, display->egl.conf, pbuffer_attribs);
+		if(EGL_NO_SURFACE == window->egl_surface)
+		{
+			printf("Headless: eglCreatePbufferSurface() failed 0x%x\n", eglGetError());
+			exit(1);
+		}
+	}
+
+	if(!eglMakeCurrent(display->egl.dpy, window->egl_surface, window->egl_surface, display->egl.ctx))
+	{
+		printf("Headless: eglMakeCurrent() failed 0x%x\n", eglGetError());
+		exit(1);
+	}
+	printf("Headless: %s context, GL_RENDERER %s\n", surfaceless ? "surfaceless" : "pbuffer",
+		(const char*)glGetString(GL_RENDERER));
+
+	// nothing to swap, so no damage either
+	display->swap_buffers_with_damage = NULL;
+}
+
+//------------------------------------------------------------------------------
+void fini_headless_egl(display* display, window* window)
+{
+	eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if(EGL_NO_SURFACE != window->egl_surface)
+	{
+		eglDestroySurface(display->egl.dpy, window->egl_surface);
+	}
+	eglDestroyContext(display->egl.dpy, display->egl.ctx);
+	eglTerminate(display->egl.dpy);
+	eglReleaseThread();
+}
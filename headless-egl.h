@@ -0,0 +1,37 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __HEADLESS_EGL_H__
+#define __HEADLESS_EGL_H__
+
+// Headless EGL backend
+// Runs the scenes without a Wayland compositor. The context comes from the
+// Mesa surfaceless platform, or the first EGL device, and every frame is
+// rendered into the offscreen framebuffer object. There is no swap, the
+// frame is finished with glFinish() so frame times are the pure GPU/driver
+// cost of the scene.
+
+// create the display, context and (if needed) a small pbuffer to bind it to
+void init_headless_egl(display* display, window* window);
+
+void fini_headless_egl(display* display, window* window);
+
+#endif // __HEADLESS_EGL_H__
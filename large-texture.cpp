@@ -0,0 +1,465 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include <png.h>
+
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "large-texture.h"
+
+#include "shaders.h" 	// quad_verts/etc
+#include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
+
+// glm math library
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+struct large_texture {
+	GLuint texture;			// 0 until the scene is first drawn
+	bool failed;			// draws the built-in texture instead
+	bool first_frame_reported;
+	GLsync first_frame_fence;	// after the first frame's draw, until it signals
+	window* first_frame_window;	// the surface whose thread polls it
+	int width, height;
+	int uploads;
+	uint64_t load_start_us;
+};
+
+static const char* g_largeTextureFile = "store1k.png";
+static large_texture g_large;
+
+// the surfaces of --threads share the texture, the first one to draw the
+// scene loads it
+static pthread_mutex_t g_largeLock = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+void set_largeTexture_file(const char* filename)
+{
+	g_largeTextureFile = filename;
+}
+
+//------------------------------------------------------------------------------
+bool largeTexture_loaded()
+{
+	pthread_mutex_lock(&g_largeLock);
+	bool loaded = (0 != g_large.texture) || g_large.failed;
+	pthread_mutex_unlock(&g_largeLock);
+	return loaded;
+}
+
+//------------------------------------------------------------------------------
+bool largeTexture_failed()
+{
+	pthread_mutex_lock(&g_largeLock);
+	bool failed = g_large.failed;
+	pthread_mutex_unlock(&g_largeLock);
+	return failed;
+}
+
+//------------------------------------------------------------------------------
+static bool texture_fits(int width, int height)
+{
+	GLint max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	if((width < 1) || (height < 1) || (width > max_size) || (height > max_size))
+	{
+		printf("Large texture: %s is %dx%d, the GPU takes at most %dx%d\n", g_largeTextureFile, width, height, max_size, max_size);
+		return false;
+	}
+	return true;
+}
+
+// report the load to first frame time once the first frame's fence has
+// signalled. It is polled at the following frames of the surface that drew
+// it, instead of waited for, so no timed frame includes the wait, and the
+// time is only as exact as the frame rate
+//------------------------------------------------------------------------------
+static void poll_first_frame(window* win)
+{
+	pthread_mutex_lock(&g_largeLock);
+	if(g_large.first_frame_fence && (g_large.first_frame_window == win))
+	{
+		GLenum status = glClientWaitSync(g_large.first_frame_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if(GL_TIMEOUT_EXPIRED != status)
+		{
+			if((GL_ALREADY_SIGNALED == status) || (GL_CONDITION_SATISFIED == status))
+			{
+				printf("Large texture: first frame done %.1f ms after the load started\n",
+					(monotonic_now_us() - g_large.load_start_us) / 1000.0);
+			}
+			glDeleteSync(g_large.first_frame_fence);
+			g_large.first_frame_fence = NULL;
+		}
+	}
+	pthread_mutex_unlock(&g_largeLock);
+}
+
+// rows per glTexSubImage2D
+//------------------------------------------------------------------------------
+static int band_rows(int height)
+{
+	if((0 == g_textureUploadRows) || ((int)g_textureUploadRows > height))
+	{
+		return height;
+	}
+	return g_textureUploadRows;
+}
+
+// allocate the whole texture, the bands are filled in with upload_band().
+// Clamped and without mipmaps, so any size works on GLES2
+//------------------------------------------------------------------------------
+static void begin_upload(int width, int height)
+{
+	g_large.width = width;
+	g_large.height = height;
+	g_large.uploads = 0;
+
+	glGenTextures(1, &g_large.texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, g_large.texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+}
+
+// GLES2 has no GL_UNPACK_ROW_LENGTH, so a band is always whole rows and can
+// be read straight from the file mapping or the decode buffer
+//------------------------------------------------------------------------------
+static void upload_band(int y, int rows, const GLubyte* pixels)
+{
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, g_large.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	g_large.uploads++;
+}
+
+// raw RGBA8, uploaded from the mapping, so the file is never copied
+//------------------------------------------------------------------------------
+static bool load_raw()
+{
+	int fd = open(g_largeTextureFile, O_RDONLY);
+	if(fd < 0)
+	{
+		printf("Large texture: can not open %s\n", g_largeTextureFile);
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) < 0)
+	{
+		printf("Large texture: can not read the size of %s\n", g_largeTextureFile);
+		close(fd);
+		return false;
+	}
+	size_t size = st.st_size;
+
+	// without a width the image is square
+	int width = g_textureRawWidth;
+	if(0 == width)
+	{
+		width = (int)sqrt((double)(size / 4));
+	}
+	size_t row_size = (size_t)width * 4;
+	if((0 == size) || (0 == width) || (0 != size % row_size) || ((0 == g_textureRawWidth) && ((size_t)width != size / row_size)))
+	{
+		printf("Large texture: %s is %zu bytes, not RGBA rows of %d pixels\n", g_largeTextureFile, size, width);
+		close(fd);
+		return false;
+	}
+	int height = size / row_size;
+	if(!texture_fits(width, height))
+	{
+		close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == mapping)
+	{
+		printf("Large texture: can not map %s\n", g_largeTextureFile);
+		return false;
+	}
+	madvise(mapping, size, MADV_SEQUENTIAL);
+
+	begin_upload(width, height);
+	int rows = band_rows(height);
+	for(int y=0; y<height; y+=rows)
+	{
+		upload_band(y, std::min(rows, height - y), (const GLubyte*)mapping + y * row_size);
+	}
+
+	// glTexSubImage2D() has copied the pixels when it returns
+	munmap(mapping, size);
+	return true;
+}
+
+// any PNG, expanded to RGBA8 and decoded a band at a time, so only one band
+// of pixels is held in memory (interlaced images need all of them)
+//------------------------------------------------------------------------------
+static bool load_png(FILE* file)
+{
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info = png ? png_create_info_struct(png) : NULL;
+	if(NULL == info)
+	{
+		printf("Large texture: out of memory for libpng\n");
+		png_destroy_read_struct(&png, NULL, NULL);
+		return false;
+	}
+
+	GLubyte* volatile band = NULL;
+	if(setjmp(png_jmpbuf(png)))
+	{
+		// libpng has printed what is wrong with the file
+		delete[] band;
+		png_destroy_read_struct(&png, &info, NULL);
+		return false;
+	}
+
+	png_init_io(png, file);
+	png_set_sig_bytes(png, 8);
+	png_read_info(png, info);
+
+	int width = png_get_image_width(png, info);
+	int height = png_get_image_height(png, info);
+	if(!texture_fits(width, height))
+	{
+		png_destroy_read_struct(&png, &info, NULL);
+		return false;
+	}
+
+	// palette, grey and 16 bit images to 8 bit RGB, plus opaque alpha if
+	// the file has none
+	png_set_expand(png);
+	png_set_strip_16(png);
+	png_set_gray_to_rgb(png);
+	png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+	int passes = png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+
+	size_t row_size = (size_t)width * 4;
+	int rows = (passes > 1) ? height : band_rows(height);
+	band = new GLubyte[row_size * rows];
+
+	begin_upload(width, height);
+	for(int y=0; y<height; y+=rows)
+	{
+		int count = std::min(rows, height - y);
+		for(int pass=0; pass<passes; pass++)
+		{
+			for(int row=0; row<count; row++)
+			{
+				png_read_row(png, band + row * row_size, NULL);
+			}
+		}
+		upload_band(y, count, band);
+	}
+	png_read_end(png, NULL);
+
+	delete[] band;
+	png_destroy_read_struct(&png, &info, NULL);
+	return true;
+}
+
+// called with g_largeLock held, by the first surface to draw the scene
+//------------------------------------------------------------------------------
+static void load_large_texture()
+{
+	g_large.load_start_us = monotonic_now_us();
+
+	bool loaded = false;
+	FILE* file = fopen(g_largeTextureFile, "rb");
+	if(NULL == file)
+	{
+		printf("Large texture: can not open %s\n", g_largeTextureFile);
+	}
+	else
+	{
+		png_byte signature[8];
+		bool is_png = (sizeof(signature) == fread(signature, 1, sizeof(signature), file)) &&
+			(0 == png_sig_cmp(signature, 0, sizeof(signature)));
+		if(is_png)
+		{
+			loaded = load_png(file);
+			fclose(file);
+		}
+		else
+		{
+			fclose(file);
+			loaded = load_raw();
+		}
+	}
+
+	if(!loaded)
+	{
+		if(g_large.texture)
+		{
+			glDeleteTextures(1, &g_large.texture);
+			g_large.texture = 0;
+		}
+		g_large.failed = true;
+		printf("Large texture: drawing the built-in texture instead\n");
+		return;
+	}
+
+	// the upload has to be complete for the load time, and before another
+	// context in the share group samples the texture
+	glFinish();
+	printf("Large texture: %s %dx%d (%.1f MB) in %d uploads, loaded in %.1f ms\n",
+		g_largeTextureFile, g_large.width, g_large.height,
+		(double)g_large.width * g_large.height * 4 / (1024.0 * 1024.0), g_large.uploads,
+		(monotonic_now_us() - g_large.load_start_us) / 1000.0);
+}
+
+// Test scene: fullscreen quad with a texture from disk
+//------------------------------------------------------------------------------
+void draw_largeTexture(void *data, struct wl_callback *callback, uint32_t time_now)
+{
+	struct window *win = (window*)data;
+
+	pthread_mutex_lock(&g_largeLock);
+	if((0 == g_large.texture) && !g_large.failed)
+	{
+		load_large_texture();
+	}
+	bool report_first_frame = !g_large.first_frame_reported && !g_large.failed;
+	g_large.first_frame_reported = true;
+	GLuint texture = g_large.failed ? g_textureID : g_large.texture;
+	pthread_mutex_unlock(&g_largeLock);
+
+	glUseProgram(win->gl_tex.program);
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_BLEND);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	poll_first_frame(win);
+
+	// callback and weston setup
+	assert(win->callback == callback);
+	win->callback = NULL;
+
+	if (callback)
+		wl_callback_destroy(callback);
+
+	// timer for moving objects and timing frame
+	float fps = calculate_fps(win, "large_texture", time_now);
+
+	// the quad doesn't move, but it is redrawn every frame as a bandwidth
+	// load, and the load is only real if the compositor takes all of it
+	damage_begin(win);
+	damage_add_full(win);
+
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// orthographic projection matrix
+	glm::mat4 _ortho_matrix = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+	glUniformMatrix4fv(win->gl_tex.projection_uniform, 1, GL_FALSE,
+			   (GLfloat *) glm::value_ptr(_ortho_matrix));
+
+	// view matrix
+	glm::vec3 v_eye(0.0f, 0.0f, -1.0f);
+	glm::vec3 v_center(0.0f, 0.0f, 0.0f);
+	glm::vec3 v_up(0.0f, 1.0f, 0.0f);
+
+	glm::mat4 view_matrix = glm::lookAt(v_eye, v_center, v_up);
+	glUniformMatrix4fv(win->gl_tex.view_uniform, 1, GL_FALSE,
+		(GLfloat *)glm::value_ptr(view_matrix));
+
+	glm::mat4 model_matrix(1.f);
+	glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE,
+		(GLfloat *)glm::value_ptr(model_matrix));
+
+	// only the texture fetch, no extra shader work
+	glUniform1f(win->gl_tex.shader_loop_count, 0);
+
+	// fullscreen quad
+	glVertexAttribPointer(win->gl_tex.pos, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
+	glVertexAttribPointer(win->gl_tex.tex1,2, GL_FLOAT, GL_FALSE, 0, quad_texcoords);
+	glEnableVertexAttribArray(win->gl_tex.pos);
+	glEnableVertexAttribArray(win->gl_tex.tex1);
+
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+
+	glDisableVertexAttribArray(win->gl_tex.pos);
+	glDisableVertexAttribArray(win->gl_tex.tex1);
+
+	// load to first frame, see poll_first_frame(). Without fences only the
+	// submission can be timed
+	if(report_first_frame)
+	{
+		if(win->display->egl.client_version >= 3)
+		{
+			pthread_mutex_lock(&g_largeLock);
+			g_large.first_frame_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			g_large.first_frame_window = win;
+			pthread_mutex_unlock(&g_largeLock);
+		}
+		else
+		{
+			printf("Large texture: first frame submitted %.1f ms after the load started\n",
+				(monotonic_now_us() - g_large.load_start_us) / 1000.0);
+		}
+	}
+
+	// draw fps
+	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
+
+	// swap, or whatever the present mode does instead
+	present_frame(win);
+}
@@ -0,0 +1,49 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __LARGE_TEXTURE_H__
+#define __LARGE_TEXTURE_H__
+
+#include <stdint.h>
+
+#include "main.h"
+
+// Large texture scene
+// Draws an image loaded from disk (--texture, store1k.png by default) over
+// the whole surface, so the texture size, up to GL_MAX_TEXTURE_SIZE, sets
+// how much memory every frame samples from. PNG files are decoded with
+// libpng, anything else is taken as raw RGBA8 rows g_textureRawWidth
+// (params file line 54, 0 = square) pixels wide and mmap'd. The texture is
+// loaded the first time the scene is drawn and uploaded in bands of
+// g_textureUploadRows rows (55) with glTexSubImage2D, which bounds how much
+// the driver has to take in one call. The load time and the time to the
+// first frame drawn with the texture are reported.
+
+void set_largeTexture_file(const char* filename);
+void draw_largeTexture(void *data, struct wl_callback *callback, uint32_t time);
+
+// the scene has loaded its texture, the load settings no longer apply
+bool largeTexture_loaded();
+
+// the file couldn't be loaded, the scene draws the built-in texture instead
+bool largeTexture_failed();
+
+#endif // __LARGE_TEXTURE_H__
@@ -38,9 +38,12 @@
 
 #include "shaders.h" 	// quad_verts/etc
 #include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
 
 // textures
-#include "dialface.h"
+#include "assets.h"
 
 // glm math library
 #include "glm/vec3.hpp"
@@ -90,7 +93,7 @@ void initialize_longShader(window *window)
 	// load textures
 	if(0==g_dialTexID) 
 	{
-		registerTexture(g_dialTexID, image_dial::width, image_dial::height, image_dial::header_data, 2);
+		uploadTexture(g_dialTexID, asset_dial_width, asset_dial_height, asset_dial_pixels);
 	}	
 }
 
@@ -99,12 +102,7 @@ void initialize_longShader(window *window)
 void draw_longShader(void *data, struct wl_callback *callback, uint32_t time_now)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 	static const uint32_t speed_div = 5;
-	EGLint buffer_age = 0;
-	
-	struct wl_region *region;
-	EGLint rect[4];
 
 	// callback and weston setup
 	assert(win->callback == callback);
@@ -116,9 +114,15 @@ void draw_longShader(void *data, struct wl_callback *callback, uint32_t time_now
 	// timer for moving objects and timing frame
 	float fps = calculate_fps(win, "long_shader", time_now);
 
+	// everything moves, the whole surface is damaged
+	damage_begin(win);
+	damage_add_full(win);
+
 	GLfloat angle = (time_now / (speed_div * 2)) % 360; 
 	
-	glViewport(0, 0, win->geometry.width, win->geometry.height);
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
 	glUseProgram(win->gl_longShader.program);	
 
 	glActiveTexture(GL_TEXTURE0);
@@ -168,31 +172,6 @@ void draw_longShader(void *data, struct wl_callback *callback, uint32_t time_now
 	// draw fps
 	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
 
-	// handle flips/weston
-	if (win->opaque || win->fullscreen) {
-		region = wl_compositor_create_region(win->display->compositor);
-		wl_region_add(region, 0, 0,
-			      win->geometry.width,
-			      win->geometry.height);
-		wl_surface_set_opaque_region(win->surface, region);
-		wl_region_destroy(region);
-	} else {
-		wl_surface_set_opaque_region(win->surface, NULL);
-	}
-	
-	if(!win->no_swapbuffer_call)
-	{		
-		if (display->swap_buffers_with_damage && buffer_age > 0) {
-			rect[0] = win->geometry.width / 4 - 1;
-			rect[1] = win->geometry.height / 4 - 1;
-			rect[2] = win->geometry.width / 2 + 2;
-			rect[3] = win->geometry.height / 2 + 2;
-			display->swap_buffers_with_damage(display->egl.dpy,
-							  win->egl_surface,
-							  rect, 1);
-		} else {
-			eglSwapBuffers(display->egl.dpy, win->egl_surface);
-		}
-	}
-	win->frames++;
+	// swap, or whatever the present mode does instead
+	present_frame(win);
 }
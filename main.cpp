@@ -26,11 +26,16 @@
 #include <math.h>
 #include <assert.h>
 #include <signal.h>
+#include <ctype.h>
 #include <cstdio> // fopen
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 #include <sys/stat.h>
+#include <pthread.h>
+#include <poll.h>
 
 #include <GLES2/gl2.h>
 #include <EGL/egl.h>
@@ -43,6 +48,18 @@
 #endif
 
 #include "draw-digits.h"
+#include "param-watch.h"
+#include "control-socket.h"
+#include "frame-stats.h"
+#include "frame-timer.h"
+#include "presenter.h"
+#include "resize-stress.h"
+#include "offscreen.h"
+#include "readback.h"
+#include "frame-check.h"
+#include "capture.h"
+#include "suite.h"
+#include "headless-egl.h"
 
 // shaders
 #include "shaders.h"
@@ -50,26 +67,78 @@
 // globals
 window  g_window;
 textRender g_TextRender;
-std::ofstream g_metricsfile;
 bool g_recordMetrics = false;
-DrawCases g_draw_case = simpleDial;
-static bool g_Initalized = false;
 unsigned int g_FramesToRender = 0;
+unsigned int g_adaptiveTolerance = 0;		// 0.1% units, 0 = fixed frame count
+unsigned int g_adaptiveMaxSeconds = 60;
+unsigned int g_fixedTimestep = 0;			// microseconds per frame, 0 = wall clock
+unsigned int g_framePacing = 0;				// PACING_xxx
+unsigned int g_timerPeriod = 16667;			// microseconds between timer paced frames
+unsigned int g_timerPhase = 0;				// microseconds after the period grid
+unsigned int g_damageTiles = 0;				// damage stress tiles per frame, 0 = scene damage
+bool g_partialRedraw = false;				// buffer age partial redraw in the dial scene
+unsigned int g_presentMode = presentSwapDamage;
+unsigned int g_resizeStress = resizeOff;
+unsigned int g_resizeInterval = 60;			// frames between resizes
+int g_resizeMinWidth = 64;					// the smallest resize stress size
+int g_resizeMinHeight = 64;
+unsigned int g_offscreenFormat = offscreenRGB565;
+unsigned int g_offscreenDepth = 16;			// depth bits, 0 = no depth buffer
+unsigned int g_offscreenSamples = 0;
+int g_offscreenWidth = 0;					// 0 = the window size
+int g_offscreenHeight = 0;
+unsigned int g_offscreenTargets = 1;		// drawn in turn
+unsigned int g_readbackMode = readbackOff;
+unsigned int g_readbackInterval = 1;		// frames between reads
+unsigned int g_readbackDepth = 3;			// pixel pack buffers in the async ring
+unsigned int g_frameCheckMode = frameCheckOff;
+unsigned int g_frameCheckInterval = 60;		// frames between hashed frames
+unsigned int g_captureMode = captureOff;
+unsigned int g_captureInterval = 1;		// frames between captured frames
+unsigned int g_captureQueue = 4;			// frames waiting for the writer
+unsigned int g_postDownsample = 2;			// half size passes before the blur
+unsigned int g_postBlurPasses = 2;
+bool g_postBloom = true;
+bool g_postTonemap = true;
+unsigned int g_textureRawWidth = 0;			// raw texture files, 0 = square
+unsigned int g_textureUploadRows = 256;		// rows per glTexSubImage2D, 0 = all
+unsigned int g_multiTextureCount = 8;
+unsigned int g_multiTextureSize = 1024;		// power of two
+unsigned int g_multiTextureFormat = 0;		// see multi-texture.h
+unsigned int g_multiTextureFalloff = 100;	// percent per texture, 100 = equal weights
+unsigned int g_streamMode = 1;				// see stream-upload.h
+unsigned int g_streamWidth = 1920;
+unsigned int g_streamHeight = 1080;
+unsigned int g_streamFormat = 0;
+static const char* g_config_filename = "params.txt";
+
+// every surface drawn by this process, g_window is always the first
+#define MAX_SURFACES 64
+static window* g_surfaces[MAX_SURFACES];
+static int g_surface_count = 0;
+static pthread_t g_render_threads[MAX_SURFACES];
+static bool g_threaded = false;
+
+// how long the frame callback loop sleeps at most before it services the
+// params file watcher and the control socket again
+#define EVENT_POLL_TIMEOUT_MS	100
+
+// the main loop and the render threads run while this is set, it is lock
+// free so the signal handler can clear it too
+std::atomic<int> running(1);
+
+// the render threads read the parameters while they draw a frame, the main
+// thread only changes them with this held for writing, so a frame sees
+// either the old or the new settings. A surface's scene is only changed by
+// the thread that draws it. The writer goes first, or the render threads
+// would keep it out
+static pthread_rwlock_t g_configLock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
 
 // texture ids
 GLuint g_textureID=0;
 GLuint g_dialTexID=0;
 GLuint g_needleTexID=0;
 
-// pyramid geometry parameters
-int x_count = 5;
-int y_count = 5;
-int z_count = 5;
-int g_batchSize = 1;
-GLfloat* pyramid_positions=NULL; 
-GLfloat* pyramid_colors_single_draw=NULL; 
-GLfloat* pyramid_transforms=NULL; 
-
 // textures
 #define checkImageWidth 64
 #define checkImageHeight 64
@@ -81,6 +150,10 @@ GLubyte checkImage[checkImageHeight][checkImageWidth][4];
 #include "single-draw.h"
 #include "long-shader.h"
 #include "simple-texture.h"
+#include "post-process.h"
+#include "large-texture.h"
+#include "multi-texture.h"
+#include "stream-upload.h"
 #include "batch-draw.h"
 
 // glm math library
@@ -113,158 +186,268 @@ int safeParse(std::string& line, const int max_digits, const int minvalue=0)
 	return value;
 }
 
-// calculate the per-frame fps 
+// per-frame metrics recording, one file per surface
+struct frame_metrics {
+	std::ofstream file;
+	uint32_t frametimes[FRAME_TIME_RECORDING_WINDOW_SIZE];
+	uint32_t frameids[FRAME_TIME_RECORDING_WINDOW_SIZE];
+	uint32_t latenesses[FRAME_TIME_RECORDING_WINDOW_SIZE];
+	uint32_t index;
+	bool written;
+	bool lateness_column;	// timer paced, the frame start lateness is saved too
+};
+
+// create a new metrics file named after the current date/time
 //------------------------------------------------------------------------------
-float calculate_fps(window *win, char* test_name, uint32_t& time_now)
+static void open_metrics_file(window* win)
 {
-	static const uint32_t benchmark_interval = 1000;
-	struct timeval tv;
-	static float fps=0.0f;
+	if(NULL == win->metrics)
+	{
+		win->metrics = new frame_metrics;
+	}
+	frame_metrics* metrics = win->metrics;
+	metrics->index = 0;
+	metrics->written = false;
+	metrics->lateness_column = (PACING_TIMER == g_framePacing);
 
-	// saving to the a file
-	static uint32_t* frametimes = NULL;
-	static uint32_t* frameids = NULL;
-	static uint32_t frametime_window_index=0;
+	// create unique metrics file name				
+	std::string filename = "metrics_";
 
-	// timer related
-	static uint64_t global_frameid = 0;
-	static uint64_t prev_frame_timestamp = 0;
-	static uint64_t now_timestamp = 0;
-	static uint64_t now = 0;
-	static uint64_t prev = 0;
+	time_t currDateTime = time(NULL);
+	struct tm* tm = localtime(&currDateTime);
 
-	// get time now
-	gettimeofday(&tv, NULL);
-	now = tv.tv_sec * 1000000 + tv.tv_usec;
-	
-	// first frame setup
-	if(0==global_frameid) { 
-		prev = now;
-	}	
+	// build filename for log using current date/time
+	if(tm)
+	{
+		std::ostringstream year,mon,mday,hour,min,sec;
+		year << tm->tm_year+1900;
+		mon << tm->tm_mon+1;
+		mday << tm->tm_mday;
+		hour << tm->tm_hour;
+		min << tm->tm_min;
+		sec << tm->tm_sec;
+
+		filename += year.str() + "-" + mon.str() + "-" + mday.str() + "__" + hour.str() + "-" + min.str() + "-" + sec.str();
+	}
+	else
+	{
+		filename += "log";
+	}
 
+	// the extra surfaces are told apart by their index
+	if(win->surface_index)
+	{
+		std::ostringstream index;
+		index << win->surface_index;
+		filename += "__surface" + index.str();
+	}
+	filename += ".cvs";
 
-	// one-time setup for first frame
-	if((NULL==frametimes) && g_recordMetrics)
+	// open new file
+	printf("Saving metrics in file: %s\n", filename.c_str());
+	metrics->file.open(filename.c_str(), std::ofstream::out ); 
+
+	// the framebuffer the frame times were measured with
+	char description[128];
+	describe_egl_config(win->display->egl.dpy, win->display->egl.conf, description, sizeof(description));
+	metrics->file << description << "\n";
+
+	// add column headers
+	if(metrics->lateness_column)
+	{
+		metrics->file << "frame,\tmicroseconds (1e-6),\tstart lateness (1e-6)\n";
+	}
+	else
 	{
-		// allocate space for circulare frame time buffer
-		frametimes = new uint32_t[FRAME_TIME_RECORDING_WINDOW_SIZE];
-		frameids = new uint32_t[FRAME_TIME_RECORDING_WINDOW_SIZE];
-		frametime_window_index=0;	
+		metrics->file << "frame,\tmicroseconds (1e-6)\n";		
+	}
+}
 
-		gettimeofday(&tv, NULL);
-		prev_frame_timestamp = tv.tv_sec * 1000000 + tv.tv_usec ; 
+// append the buffered frame times to the metrics file
+//------------------------------------------------------------------------------
+static void dump_metrics(frame_metrics* metrics)
+{
+	if(0 == metrics->index)
+	{
+		return;
+	}
 
-		// create unique metrics file name				
-		std::string filename = "metrics_";
+	printf("dumping metrics...\n");
 
-		time_t currDateTime = time(NULL);
-		struct tm* tm = localtime(&currDateTime);
+	// dump to file
+	if(metrics->written)
+	{
+		metrics->file << ",\n";
+	}
 
-		// build filename for log using current date/time
-		if(tm)
+	for(uint32_t i=0; i<metrics->index; i++)
+	{
+		if(i)
 		{
-			std::ostringstream year,mon,mday,hour,min,sec;
-			year << tm->tm_year+1900;
-			mon << tm->tm_mon+1;
-			mday << tm->tm_mday;
-			hour << tm->tm_hour;
-			min << tm->tm_min;
-			sec << tm->tm_sec;
-
-			filename += year.str() + "-" + mon.str() + "-" + mday.str() + "__" + hour.str() + "-" + min.str() + "-" + sec.str() + ".cvs";
+			metrics->file << ",\n";
 		}
-		else
+		metrics->file << metrics->frameids[i] << ",\t" << metrics->frametimes[i];
+		if(metrics->lateness_column)
 		{
-			filename += "log";
+			metrics->file << ",\t" << metrics->latenesses[i];
 		}
+	}
 
-		// open new file
-		printf("Saving metrics in file: %s\n", filename.c_str());
-		g_metricsfile.open(filename.c_str(), std::ofstream::out ); 
+	metrics->index = 0;
+	metrics->written = true;
+}
 
-		// possibly store scene/configuration settings here
+// write out whatever is still buffered and close the metrics files
+//------------------------------------------------------------------------------
+static void close_metrics_files()
+{
+	for(int i=0; i<g_surface_count; i++)
+	{
+		frame_metrics* metrics = g_surfaces[i]->metrics;
+		if(metrics && metrics->file.is_open())
+		{
+			dump_metrics(metrics);
+			metrics->file.close();
+		}
+	}
+}
 
-		// add column headers
-		g_metricsfile << "frame,\tmicroseconds (1e-6)\n";		
+// start or stop saving per-frame metrics while running
+// each start creates a new metrics file per surface
+//------------------------------------------------------------------------------
+static void change_metrics_recording(bool enable)
+{
+	if(enable == g_recordMetrics)
+	{
+		return;
 	}
 
-	// if the frame metrics buffer is full, append it to the file
-	if((frametime_window_index >= FRAME_TIME_RECORDING_WINDOW_SIZE-1) && g_recordMetrics)
+	if(!enable)
 	{
-		printf("dumping metrics...\n");
+		close_metrics_files();
+	}
 
-		// dump to file
-		if(FRAME_TIME_RECORDING_WINDOW_SIZE < global_frameid)
-		{
-			g_metricsfile << ",\n";
-		}
+	// the files get opened by the next calculate_fps() call
+	g_recordMetrics = enable;
+	printf("Record metrics = %s\n", (g_recordMetrics) ? "true" : "false" );
+}
 
+// the render threads write their metrics files while they draw
+//------------------------------------------------------------------------------
+void set_metrics_recording(bool enable)
+{
+	pthread_rwlock_wrlock(&g_configLock);
+	change_metrics_recording(enable);
+	pthread_rwlock_unlock(&g_configLock);
+}
 
-		for(int i=0; i<FRAME_TIME_RECORDING_WINDOW_SIZE-2; i++)
-		{
-			g_metricsfile << frameids[i] << ",\t" << frametimes[i] << ",\n" ;
-		}
-		g_metricsfile << frameids[FRAME_TIME_RECORDING_WINDOW_SIZE-2] << ",\t" << frametimes[FRAME_TIME_RECORDING_WINDOW_SIZE-2] ;
+// calculate the per-frame fps 
+//------------------------------------------------------------------------------
+float calculate_fps(window *win, char* test_name, uint32_t& time_now)
+{
+	static const uint32_t benchmark_interval = 1000;
+	struct timeval tv;
 
-		frametime_window_index = 0;
+	// get time now
+	gettimeofday(&tv, NULL);
+	uint64_t now = tv.tv_sec * 1000000 + tv.tv_usec;
+	
+	// first frame setup
+	if(0==win->frame_id) { 
+		win->interval_start = now;
+		win->prev_frame_timestamp = now;
+	}	
+
+	// frame time since the previous frame
+	win->frame_time_us = (uint32_t)(now - win->prev_frame_timestamp);
+	win->prev_frame_timestamp = now;
+
+	// one-time setup for first frame
+	if(g_recordMetrics && !(win->metrics && win->metrics->file.is_open()))
+	{
+		open_metrics_file(win);
+	}
+
+	// if the frame metrics buffer is full, append it to the file
+	if(g_recordMetrics && (win->metrics->index >= FRAME_TIME_RECORDING_WINDOW_SIZE-1))
+	{
+		dump_metrics(win->metrics);
 	}
 
 
 	// store the time and frame id if we are recording metrics
 	if(g_recordMetrics) 
 	{		
-		now_timestamp = tv.tv_sec * 1000000 + tv.tv_usec;
-
-		frametimes[frametime_window_index] = (now_timestamp - prev_frame_timestamp);
-		frameids[frametime_window_index] = global_frameid;
+		win->metrics->frametimes[win->metrics->index] = win->frame_time_us;
+		win->metrics->frameids[win->metrics->index] = win->frame_id;
+		win->metrics->latenesses[win->metrics->index] = win->start_lateness_us;
 
-		prev_frame_timestamp = now_timestamp;
-		frametime_window_index++;
+		win->metrics->index++;
 	}
 
 	// calculate delta since interval start
-	uint64_t timeDelta = now - prev;
+	uint64_t timeDelta = now - win->interval_start;
 
 	// calculate fps if we have exceeded the benchmark interval 
 	if (timeDelta > (benchmark_interval * 1000)) 
 	{
-		fps = (float) ((double)win->frames / ((double) timeDelta / 1000000.0));
-		printf("%s: %d frames in %.4f seconds: %.4f fps. \n", 
+		win->fps = (float) ((double)win->frames / ((double) timeDelta / 1000000.0));
+		if(win->surface_index)
+		{
+			printf("[surface %d] ", win->surface_index);
+		}
+		printf("%s: %d frames in %.4f seconds: %.4f fps. present %.3f ms\n", 
 				test_name,
 		       	win->frames,
 		       	timeDelta/1000000.0, 
-		       	fps);
-		prev = now;
+		       	win->fps,
+		       	win->frames ? win->present_time_sum_us / 1000.0 / win->frames : 0.0);
+		win->present_time_sum_us = 0;
+		win->interval_start = now;
 		win->frames = 0;
 		win->benchmark_time = now;
 
 	}	
-	time_now = now / 1000.0;
+	// animation time in milliseconds, either from the wall clock or from a
+	// fixed timestep so frame N always renders the same content
+	if(g_fixedTimestep)
+	{
+		time_now = (uint32_t)((win->frame_id * g_fixedTimestep) / 1000);
+	}
+	else
+	{
+		time_now = now / 1000.0;
+	}
 
-	// increment the global frame id
-	// the global frame id never resets, starts from first app frame
-	global_frameid++;			
+	// the frame id never resets, starts from the surface's first frame
+	win->frame_id++;
 
-	return fps;
+	// the onscreen counter is part of the rendered content, so it shows the
+	// simulated rate rather than the measured one
+	if(g_fixedTimestep)
+	{
+		return 1000000.0f / g_fixedTimestep;
+	}
+	return win->fps;
 }
 
 // This function generates the gigantic draw buffers that have all the pyramids
 // verts, colors, and transforms to make a single draw call
 //------------------------------------------------------------------------------
-void generate_pyramid_buffers()
+void generate_pyramid_buffers(window* win)
 {
 	// allocate space for pyramid verts/colors/etc
 	printf("Allocating mesh space...\n");
-	if(pyramid_positions)
-		delete [] pyramid_positions;
-	if(pyramid_colors_single_draw)
-		delete [] pyramid_colors_single_draw;
-	if(pyramid_transforms)
-		delete [] pyramid_transforms;
+	if(win->pyramid_positions)
+		delete [] win->pyramid_positions;
+	if(win->pyramid_colors_single_draw)
+		delete [] win->pyramid_colors_single_draw;
+	if(win->pyramid_transforms)
+		delete [] win->pyramid_transforms;
 
-	pyramid_positions = new GLfloat[(3 * 18) * (x_count * y_count * z_count)];
-	pyramid_colors_single_draw = new GLfloat[(4 * 18) * (x_count * y_count * z_count)];
-	pyramid_transforms = new GLfloat[(3 * 18) * (x_count * y_count * z_count)];	
+	win->pyramid_positions = new GLfloat[(3 * 18) * (win->x_count * win->y_count * win->z_count)];
+	win->pyramid_colors_single_draw = new GLfloat[(4 * 18) * (win->x_count * win->y_count * win->z_count)];
+	win->pyramid_transforms = new GLfloat[(3 * 18) * (win->x_count * win->y_count * win->z_count)];	
 
 
 	// set up the pyramid transforms
@@ -272,19 +455,19 @@ void generate_pyramid_buffers()
 
 	int pyramid_index=0;
 	// render back to front
-	for(int z=z_count; z>=1; z--)
+	for(int z=win->z_count; z>=1; z--)
 	{
-		for(int x=1; x<=x_count; x++)
+		for(int x=1; x<=win->x_count; x++)
 		{
-			for(int y=1; y<=y_count; y++)
+			for(int y=1; y<=win->y_count; y++)
 			{				
 				for(unsigned int i=0;i<18;i++)
 				{
-					pyramid_transforms[3*(pyramid_index)+0] = (x-1.0f)*3.0f;
-					pyramid_transforms[3*(pyramid_index)+1] = (y-1.0f)*3.0f;
-					pyramid_transforms[3*(pyramid_index)+2] = (z-1.0f)*3.0f;
+					win->pyramid_transforms[3*(pyramid_index)+0] = (x-1.0f)*3.0f;
+					win->pyramid_transforms[3*(pyramid_index)+1] = (y-1.0f)*3.0f;
+					win->pyramid_transforms[3*(pyramid_index)+2] = (z-1.0f)*3.0f;
 
-					//printf("(%.1f, %.1f, %.1f)\n",pyramid_transforms[3*(pyramid_index)+0], pyramid_transforms[3*(pyramid_index)+1], pyramid_transforms[3*(pyramid_index)+2]);
+					//printf("(%.1f, %.1f, %.1f)\n",win->pyramid_transforms[3*(pyramid_index)+0], win->pyramid_transforms[3*(pyramid_index)+1], win->pyramid_transforms[3*(pyramid_index)+2]);
 					pyramid_index++;
 				}
 			}
@@ -295,9 +478,9 @@ void generate_pyramid_buffers()
 	printf("Generating positions...\n");
 
 	int source_index=0;
-	for(int i=0; i<(x_count*y_count*z_count)*(18*3); i++)
+	for(int i=0; i<(win->x_count*win->y_count*win->z_count)*(18*3); i++)
 	{
-		pyramid_positions[i] = pyramid_verts[source_index];		
+		win->pyramid_positions[i] = pyramid_verts[source_index];		
 
 		source_index++;
 		if(source_index==18*3)
@@ -307,9 +490,9 @@ void generate_pyramid_buffers()
 	// vert colors
 	printf("Generating colors...\n");
 	source_index=0;
-	for(int i=0; i<(x_count*y_count*z_count)*(18*4); i++)
+	for(int i=0; i<(win->x_count*win->y_count*win->z_count)*(18*4); i++)
 	{
-		pyramid_colors_single_draw[i] = pyramid_colors[source_index];
+		win->pyramid_colors_single_draw[i] = pyramid_colors[source_index];
 
 		source_index++;
 		if(source_index==18*4)
@@ -319,6 +502,44 @@ void generate_pyramid_buffers()
 	}
 }
 
+// an OpenGL ES 3 context when the driver has one, for the offscreen formats
+// and MSAA, otherwise OpenGL ES 2. Contexts sharing with the first one get
+// the same version
+//------------------------------------------------------------------------------
+EGLContext create_gles_context(display* display, EGLContext share)
+{
+	EGLint version = display->egl.client_version ? display->egl.client_version : 3;
+	for(; version >= 2; version--)
+	{
+		EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE };
+		EGLContext context = eglCreateContext(display->egl.dpy, display->egl.conf, share, context_attribs);
+		if(EGL_NO_CONTEXT != context)
+		{
+			display->egl.client_version = version;
+			return context;
+		}
+	}
+	return EGL_NO_CONTEXT;
+}
+
+// give the surface a new size: the Wayland window, the offscreen targets
+// that follow it and the viewport. The window's buffers get reallocated by
+// the next frame
+//------------------------------------------------------------------------------
+void resize_surface(window* win, int width, int height)
+{
+	win->geometry.width = width;
+	win->geometry.height = height;
+	if(win->native)
+	{
+		wl_egl_window_resize(win->native, width, height, 0, 0);
+	}
+	offscreen_resize(win);
+
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
+}
+
 // initialize/loading the gl resources for our scenes
 //------------------------------------------------------------------------------
 void init_gl(struct window *window)
@@ -333,6 +554,10 @@ void init_gl(struct window *window)
 
 	initialize_simpleTexture(window);
 
+	initialize_postProcess(window);
+
+	initialize_multiTexture(window);
+
 	initialize_longShader(window);
 
 	initialize_batchDrawArrays(window);
@@ -344,44 +569,8 @@ void init_gl(struct window *window)
 	// draw offscreen
 	if(g_window.offscreen)
 	{
-		// create a framebuffer object
-	    GLuint fboId = 0;
-
-	    GLuint renderBufferWidth = g_window.geometry.width;
-	    GLuint renderBufferHeight = g_window.geometry.height;	
-	    glGenFramebuffers(1, &fboId);
-	    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
-
-
-	    printf("glBindFramebuffer() = '0x%08x'\n", glGetError());
-	    GLuint renderBuffer=0;
-	    glGenRenderbuffers(1, &renderBuffer);
-	    glBindRenderbuffer(GL_RENDERBUFFER, renderBuffer);
-	    printf("glBindRenderbuffer() = '0x%08x'\n", glGetError());
-	    glRenderbufferStorage(GL_RENDERBUFFER,
-	                           GL_RGB565,
-	                           renderBufferWidth,
-	                           renderBufferHeight);
-	    printf("glRenderbufferStorage() = '0x%08x'\n", glGetError());
-	    glFramebufferRenderbuffer(GL_FRAMEBUFFER,
-	                               GL_COLOR_ATTACHMENT0,
-	                               GL_RENDERBUFFER,
-	                               renderBuffer);
-
-	    printf("glFramebufferRenderbuffer() = '0x%08x'\n", glGetError());
-	    GLuint depthRenderbuffer;
-	    glGenRenderbuffers(1, &depthRenderbuffer);
-	    glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
-	    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,     renderBufferWidth, renderBufferHeight);
-	    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
-
-	      // check FBO status
-	    GLenum fbstatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	    if(fbstatus != GL_FRAMEBUFFER_COMPLETE) {
-	    	printf("Problem with OpenGL framebuffer after specifying color render buffer: \n%x\n", fbstatus);
-	    } else {
-	        printf("FBO creation succedded\n");
-		}
+		// the render targets, see offscreen.h
+		offscreen_init(window);
 
 		// we must query for the format of the offscreen buffer
 		// opengl es has very limited offscreen buffer formats
@@ -401,23 +590,29 @@ void init_gl(struct window *window)
 		printf("\n");
 		
 
-		// prime the buffers
-		eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
-		eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
-		eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
-		printf("eglSwapBuffers() = '0x%08x'\n", glGetError());
+		// prime the buffers, there is nothing to swap when headless
+		if(!g_window.headless)
+		{
+			eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
+			eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
+			eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
+			printf("eglSwapBuffers() = '0x%08x'\n", glGetError());
+		}
 
 		glClearColor(1.0,0.0,1.0,1.0);
 		glClear(GL_COLOR_BUFFER_BIT);
-		eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
+		if(!g_window.headless)
+		{
+			eglSwapBuffers(g_window.display->egl.dpy, g_window.egl_surface);
+		}
 
 	#if DISPLAY_OFFSCREEN_BUFFER_CONTENTS_FOR_TESTING
 		// test code to validate we wrote to the output buffer
 		// color of 1,0,1,1 = 0xf81f = 1111100000011111 in 5-6-5 format
-		int size = 4 * renderBufferHeight * renderBufferWidth;
+		int size = 4 * window->geometry.height * window->geometry.width;
 		unsigned char *data = new unsigned char[size];
 
-		glReadPixels(0,0,renderBufferWidth,renderBufferHeight,GL_RGB, GL_UNSIGNED_SHORT_5_6_5, data);
+		glReadPixels(0,0,window->geometry.width,window->geometry.height,GL_RGB, GL_UNSIGNED_SHORT_5_6_5, data);
 		printf("glReadPixels() = '%s'\n", glGetError());
 
 		for(int i=0; i<3; i++)
@@ -444,10 +639,12 @@ void init_gl(struct window *window)
 	
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glViewport(0, 0, window->geometry.width, window->geometry.height);
+	int width, height;
+	render_target_size(window, width, height);
+	glViewport(0, 0, width, height);
 
 	// create the single_draw pyramid buffers
-	generate_pyramid_buffers();
+	generate_pyramid_buffers(window);
 
 	// textures
 	glUseProgram(window->gl_tex.program);
@@ -455,75 +652,178 @@ void init_gl(struct window *window)
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	g_Initalized = true;	
 
 }
 
 
 
-// swap which scene we're drawing
+// printable name of a scene
+//------------------------------------------------------------------------------
+const char* draw_case_name(DrawCases drawcase)
+{
+	switch(drawcase)
+	{
+		case simpleDial:		return "simpleDial";
+		case singleDrawArrays:	return "singleDrawArrays";
+		case multiDrawArrays:	return "multiDrawArrays";
+		case simpleTexture:		return "simpleTexture";
+		case longShader:		return "longShader";
+		case batchDrawArrays:	return "batchDrawArrays";
+		case multiTexture:		return "multiTexture";
+		case largeTexture:		return "largeTexture";
+		case postProcess:		return "postProcess";
+		case streamUpload:		return "streamUpload";
+		default:				return "unknown";
+	}
+}
+
+// the scenes that can be drawn, the others are future cases
+//------------------------------------------------------------------------------
+bool draw_case_valid(int drawcase)
+{
+	return ((drawcase >= simpleDial) && (drawcase <= batchDrawArrays)) || (multiTexture == drawcase) || (largeTexture == drawcase) || (postProcess == drawcase) || (streamUpload == drawcase);
+}
+
+// print the scene that was just switched to
+//------------------------------------------------------------------------------
+static void print_draw_case(window* win)
+{
+	switch(win->draw_case)
+	{
+		case multiDrawArrays:
+			printf("Test case: multiDrawArrays: (%d x %d x %d) = %d pyramids\n", win->x_count, win->y_count, win->z_count, (win->x_count*win->y_count*win->z_count));
+			break;
+
+		case batchDrawArrays:
+			printf("Test case: BatchDrawArrays: (%d x %d x %d) = %d pyramids in %d batches of %d draw calls\n", win->x_count, win->y_count, win->z_count, (win->x_count*win->y_count*win->z_count), win->batch_size, (win->x_count*win->y_count*win->z_count)/win->batch_size);				
+			break;
+
+		case longShader:
+			printf("Test case: LongShader: %.0f loops\n", win->longShader_loop_count);
+			break;
+
+		case simpleDial:
+			printf("Test case: SimpleDial: %.0f loops\n", win->dialsShader_loop_count);	
+			break;				
+
+		case singleDrawArrays:
+			printf("Test case: SingleDrawArrays: (%d x %d x %d) = %d pyramids\n", win->x_count, win->y_count, win->z_count, (win->x_count*win->y_count*win->z_count));				
+			break;
+
+		case simpleTexture:
+			printf("Text case: SimpleTexture:\n");
+			break;
+
+		case multiTexture:
+			printf("Test case: MultiTexture: %u textures of %ux%u %s, %u%% weight falloff = %.1f MB working set\n",
+				g_multiTextureCount, g_multiTextureSize, g_multiTextureSize, multi_texture_format_name(g_multiTextureFormat),
+				g_multiTextureFalloff, multi_texture_working_set() / (1024.0 * 1024.0));
+			break;
+
+		case largeTexture:
+			printf("Test case: LargeTexture:\n");
+			break;
+
+		case streamUpload:
+			printf("Test case: StreamUpload: %ux%u %s, %s\n", g_streamWidth, g_streamHeight,
+				stream_format_name(g_streamFormat), stream_mode_name(g_streamMode));
+			break;
+
+		case postProcess:
+			printf("Test case: PostProcess: %u downsamples, %u blur passes, bloom %s, tonemap %s = %d fullscreen passes\n",
+				std::min(g_postDownsample, (unsigned int)MAX_POST_DOWNSAMPLES), g_postBlurPasses,
+				g_postBloom ? "on" : "off", g_postTonemap ? "on" : "off", post_process_pass_count());
+			break;
+
+		default:
+			printf("Unknown test case\n");
+	};
+}
+
+// swap which scene we're drawing, either to the given scene or the next one
 //------------------------------------------------------------------------------
 void swap_draw_case(window* win, DrawCases drawcase)
 {
-	switch(g_draw_case)
+	// a new scene restarts the warm-up detection
+	adaptive_run_configure(g_adaptiveTolerance, g_adaptiveMaxSeconds);
+
+	if(next_case != drawcase)
+	{
+		win->draw_case = drawcase;
+		print_draw_case(win);
+		return;
+	}
+
+	switch(win->draw_case)
 	{
 		case singleDrawArrays:
-			g_draw_case = multiDrawArrays;
-			printf("Test case: multiDrawArrays: (%d x %d x %d) = %d pyramids\n", x_count, y_count, z_count, (x_count*y_count*z_count));
+			win->draw_case = multiDrawArrays;
 			break;
 
 		case multiDrawArrays:
-			g_draw_case = batchDrawArrays;
-			printf("Test case: BatchDrawArrays: (%d x %d x %d) = %d pyramids in %d batches of %d draw calls\n", x_count, y_count, z_count, (x_count*y_count*z_count), g_batchSize, (x_count*y_count*z_count)/g_batchSize);				
+			win->draw_case = batchDrawArrays;
 			break;
 
 		case simpleTexture:
-			g_draw_case = longShader;
-			printf("Test case: LongShader: %.0f loops\n", win->longShader_loop_count);
+			win->draw_case = largeTexture;
+			break;
+
+		case largeTexture:
+			win->draw_case = multiTexture;
+			break;
+
+		case multiTexture:
+			win->draw_case = postProcess;
+			break;
+
+		case postProcess:
+			win->draw_case = streamUpload;
+			break;
+
+		case streamUpload:
+			win->draw_case = longShader;
 			break;
 
 		case longShader:
-			g_draw_case = simpleDial;
-			printf("Test case: SimpleDial: %.0f loops\n", win->dialsShader_loop_count);	
+			win->draw_case = simpleDial;
 			break;				
 
 		case simpleDial:
-			g_draw_case = singleDrawArrays;
-			printf("Test case: SingleDrawArrays: (%d x %d x %d) = %d pyramids\n", x_count, y_count, z_count, (x_count*y_count*z_count));				
+			win->draw_case = singleDrawArrays;
 			break;
 
 		case batchDrawArrays:
-			g_draw_case = simpleTexture;			
-			printf("Text case: SimpleTexture:\n");
+			win->draw_case = simpleTexture;			
 			break;
 
 		default:
-			printf("Unknown test case\n");
+			break;
 	};
+	print_draw_case(win);
 }
 
 
 // Increase the amount of work being done for long shader and single/mulit shader
 //-----------------------------------------------------------------------------
-void add_shader_loops(DrawCases scene)
+void add_shader_loops(window* win, DrawCases scene)
 {		
 	switch(scene)
 	{
 		case simpleDial:	
-			g_window.dialsShader_loop_count += 25;
-			printf("Per-pixel dials shader loop count = %.0f\n", g_window.dialsShader_loop_count);	
+			win->dialsShader_loop_count += 25;
+			printf("Per-pixel dials shader loop count = %.0f\n", win->dialsShader_loop_count);	
 			break;
 
 		case singleDrawArrays:
 		case multiDrawArrays:
 		case batchDrawArrays:
-			g_window.shortShader_loop_count += 25;
-			printf("Per-pixel pyramid shader loop count = %.0f\n", g_window.shortShader_loop_count);
+			win->shortShader_loop_count += 25;
+			printf("Per-pixel pyramid shader loop count = %.0f\n", win->shortShader_loop_count);
 			break;
 
 		case longShader:
-			g_window.longShader_loop_count += 50;
-			printf("Per-pixel long shader loop count = %.0f\n", g_window.longShader_loop_count);
+			win->longShader_loop_count += 50;
+			printf("Per-pixel long shader loop count = %.0f\n", win->longShader_loop_count);
 			break;			
 		default:
 			break;
@@ -532,77 +832,78 @@ void add_shader_loops(DrawCases scene)
 
 // decrease the amount of work being done for long shader and single/mulit shader
 //-----------------------------------------------------------------------------
-void shrink_shader_loops(DrawCases scene)
+void shrink_shader_loops(window* win, DrawCases scene)
 {
 	switch(scene)
 	{
 		case simpleDial:
-			g_window.dialsShader_loop_count -= 25;
-			if( g_window.dialsShader_loop_count<0 )
+			win->dialsShader_loop_count -= 25;
+			if( win->dialsShader_loop_count<0 )
 			{
-				g_window.dialsShader_loop_count=0;
+				win->dialsShader_loop_count=0;
 			}
-			printf("Per-pixel dials shader loop count = %.0f\n", g_window.dialsShader_loop_count);	
+			printf("Per-pixel dials shader loop count = %.0f\n", win->dialsShader_loop_count);	
 			break;
 
 
 		case singleDrawArrays:
 		case multiDrawArrays:
 		case batchDrawArrays:		
-			g_window.shortShader_loop_count -= 25;
-			if(g_window.shortShader_loop_count<0) {
-				g_window.shortShader_loop_count = 0;
+			win->shortShader_loop_count -= 25;
+			if(win->shortShader_loop_count<0) {
+				win->shortShader_loop_count = 0;
 			}
-			printf("Per-pixel short shader loop count = %.0f\n", g_window.shortShader_loop_count);
+			printf("Per-pixel short shader loop count = %.0f\n", win->shortShader_loop_count);
 			break;
 		default:
 		case longShader:	
-			g_window.longShader_loop_count -= 50;
-			if(g_window.longShader_loop_count<0) {
-				g_window.longShader_loop_count = 0;
+			win->longShader_loop_count -= 50;
+			if(win->longShader_loop_count<0) {
+				win->longShader_loop_count = 0;
 			}
-			printf("Per-pixel long shader loop count = %.0f\n", g_window.longShader_loop_count);
+			printf("Per-pixel long shader loop count = %.0f\n", win->longShader_loop_count);
 			break;			
 	}
 }
 
 // increase the number of pyramids drawing in the single/multi draw case
 //-----------------------------------------------------------------------------
-void add_pyramids()
+void add_pyramids(window* win)
 {		
-		x_count += 5;
-		y_count += 5;
-		z_count += 5;
+		win->x_count += 5;
+		win->y_count += 5;
+		win->z_count += 5;
 
-		generate_pyramid_buffers();
+		generate_pyramid_buffers(win);
 
-		printf("Pyramid count = (%d x %d x %d) = %d \n", x_count, y_count, z_count, x_count*y_count*z_count);
+		printf("Pyramid count = (%d x %d x %d) = %d \n", win->x_count, win->y_count, win->z_count, win->x_count*win->y_count*win->z_count);
 
 }
 
 // reduce the number of pyramids drawing in the single/multi draw case
 //-----------------------------------------------------------------------------
-void remove_pyramids()
+void remove_pyramids(window* win)
 {		
-		x_count -= 5;
-		y_count -= 5;
-		z_count -= 5;
-
-		if(x_count<=3)
-			x_count=3;
-		if(y_count<=3)
-			y_count=3;
-		if(z_count<=3)
-			z_count=3;	
+		win->x_count -= 5;
+		win->y_count -= 5;
+		win->z_count -= 5;
+
+		if(win->x_count<=3)
+			win->x_count=3;
+		if(win->y_count<=3)
+			win->y_count=3;
+		if(win->z_count<=3)
+			win->z_count=3;	
 		
-		generate_pyramid_buffers();
-		printf("Pyramid count = (%d x %d x %d) = %d \n", x_count, y_count, z_count, x_count*y_count*z_count);				
+		generate_pyramid_buffers(win);
+		printf("Pyramid count = (%d x %d x %d) = %d \n", win->x_count, win->y_count, win->z_count, win->x_count*win->y_count*win->z_count);				
 }
 
 
-// read the params.txt file to get all our running parameters
+// read the params.txt file to get all our running parameters for a surface
+// when reloading, a missing or truncated file is reported instead of exiting
 //------------------------------------------------------------------------------
-int read_config_file(char* config_filename)
+int read_config_file(window* win, const char* config_filename, bool reload=false)
 {
 	char filename[] = "params.txt";
 	struct stat statbuff;
@@ -617,6 +918,10 @@ int read_config_file(char* config_filename)
 		if(err)
 		{	
 			printf("Error opening %s parameters file\n", config_filename);
+			if(reload)
+			{
+				return -1;
+			}
 			exit(1);
 		}	
 
@@ -628,6 +933,10 @@ int read_config_file(char* config_filename)
 		if(err)
 		{	
 			printf("Error opening the params.txt parameters file\n");
+			if(reload)
+			{
+				return -1;
+			}
 			exit(1);
 		}		
 		infile.open("params.txt");			
@@ -637,41 +946,49 @@ int read_config_file(char* config_filename)
 	std::string line;
 	const int max_digits = 5;
 	std::getline(infile, line);		
-	g_window.geometry.width = safeParse(line, max_digits); 
+	win->geometry.width = safeParse(line, max_digits); 
 	std::getline(infile, line);		
-	g_window.geometry.height = safeParse(line, max_digits);
-	printf("Window dimensions = (%d,%d)\n", g_window.geometry.width, g_window.geometry.height );	
+	win->geometry.height = safeParse(line, max_digits);
+	printf("Window dimensions = (%d,%d)\n", win->geometry.width, win->geometry.height );	
+	// the windowed size, a reload changes it in apply_config_changes()
+	if(!reload)
+	{
+		win->window_size = win->geometry;
+	}
 
 	// run fullscreen?
 	std::getline(infile, line);		
-	g_window.fullscreen = safeParse(line, 1);
-	printf("Window running fullscreen = %s\n", (g_window.fullscreen) ? "true" : "false" );
+	win->fullscreen = safeParse(line, 1);
+	printf("Window running fullscreen = %s\n", (win->fullscreen) ? "true" : "false" );
 
-	// record metrics to a file?
+	// record metrics to a file? same for all surfaces
 	std::getline(infile, line);		
-	g_recordMetrics = safeParse(line, 1);
-	printf("Record metrics = %s\n", (g_recordMetrics) ? "true" : "false" );		
+	if(win == &g_window)
+	{
+		g_recordMetrics = safeParse(line, 1);
+		printf("Record metrics = %s\n", (g_recordMetrics) ? "true" : "false" );		
+	}
 
 	// run offscreen
 	std::getline(infile, line);		
-	g_window.offscreen = safeParse(line, 1);
-	printf("draw offscreen = %s\n", (g_window.offscreen) ? "true" : "false" );		
+	win->offscreen = safeParse(line, 1);
+	printf("draw offscreen = %s\n", (win->offscreen) ? "true" : "false" );		
 
 	// Enable vsync
 	std::getline(infile, line);		
-	g_window.frame_sync = safeParse(line, 1);
-	printf("vsync = %d\n", g_window.frame_sync );		
+	win->frame_sync = safeParse(line, 1);
+	printf("vsync = %d\n", win->frame_sync );		
 
 	// Do not call swap buffers?
 	std::getline(infile, line);		
-	g_window.no_swapbuffer_call = safeParse(line, 1);
-	printf("no_swapbuffer_call = %d\n", g_window.no_swapbuffer_call );			
+	win->no_swapbuffer_call = safeParse(line, 1);
+	printf("no_swapbuffer_call = %d\n", win->no_swapbuffer_call );			
 
 	// which scene to draw
 	std::getline(infile, line);
-	g_draw_case = (DrawCases) safeParse(line, 1);
+	win->draw_case = (DrawCases) safeParse(line, 1);
 
-	switch (g_draw_case)
+	switch (win->draw_case)
 	{
 	case multiDrawArrays:
 		printf("Scene: multiDrawArrays\n");
@@ -691,59 +1008,78 @@ int read_config_file(char* config_filename)
     	case batchDrawArrays:
 		printf("Scene: batchDrawArrays\n");
 		break;    		
+	case multiTexture:
+		printf("Scene: multiTexture\n");
+		break;
+	case largeTexture:
+		printf("Scene: largeTexture\n");
+		break;
+	case postProcess:
+		printf("Scene: postProcess\n");
+		break;
+	case streamUpload:
+		printf("Scene: streamUpload\n");
+		break;
 
 	default:
 		printf("Scene not supported, defaulting to dials\n");
-		g_draw_case = simpleDial;
+		win->draw_case = simpleDial;
 	}
 
 	// use the flat grey shader for the texture scene?
 	std::getline(infile, line);		
-	g_window.texture_flat_no_rotate = safeParse(line, 1);
-	printf("Texture scene using simple shader = %s\n", (g_window.texture_flat_no_rotate) ? "true" : "false" );		
+	win->texture_flat_no_rotate = safeParse(line, 1);
+	printf("Texture scene using simple shader = %s\n", (win->texture_flat_no_rotate) ? "true" : "false" );		
 
 	// if not using the flat gray shader on the texture scene, what is the 
 	// blur kernel radius
 	std::getline(infile, line);
-	g_window.texture_fetch_radius = (float)safeParse(line, max_digits);
-	if(g_window.texture_fetch_radius < 1) 
+	win->texture_fetch_radius = (float)safeParse(line, max_digits);
+	if(win->texture_fetch_radius < 1) 
 	{
-		g_window.texture_fetch_radius = 1;
+		win->texture_fetch_radius = 1;
 	}
-	printf("Texture scene using fetch radius of = %.0f\n", g_window.texture_fetch_radius);				
+	printf("Texture scene using fetch radius of = %.0f\n", win->texture_fetch_radius);				
 
 	// pyramid scene counts
 	std::getline(infile, line);
-	x_count = safeParse(line, max_digits, 1);
+	win->x_count = safeParse(line, max_digits, 1);
 	std::getline(infile, line);
-	y_count = safeParse(line, max_digits, 1);
+	win->y_count = safeParse(line, max_digits, 1);
 	std::getline(infile, line);
-	z_count = safeParse(line, max_digits, 1);
+	win->z_count = safeParse(line, max_digits, 1);
 	std::getline(infile, line);
-	g_batchSize = safeParse(line, max_digits, 1);
+	win->batch_size = safeParse(line, max_digits, 1);
 
-	printf("pyramid scenes dimensions: %dx%dx%d ", x_count, y_count, z_count);
-	if(batchDrawArrays != g_draw_case)
+	printf("pyramid scenes dimensions: %dx%dx%d ", win->x_count, win->y_count, win->z_count);
+	if(batchDrawArrays != win->draw_case)
 	{
 		printf("\n");
 	} else {
-		printf("in %d batches\n",  g_batchSize);
+		printf("in %d batches\n",  win->batch_size);
 	}
 
 	// pyramid shader loop count
 	std::getline(infile, line);
-	g_window.shortShader_loop_count = (float) safeParse(line, max_digits);		
-	printf("pyramid shader loop iterations: %.0f\n", g_window.shortShader_loop_count);
+	win->shortShader_loop_count = (float) safeParse(line, max_digits);		
+	printf("pyramid shader loop iterations: %.0f\n", win->shortShader_loop_count);
 
 	// dials shader loop count
 	std::getline(infile, line);
-	g_window.dialsShader_loop_count = (float) safeParse(line, max_digits);		
-	printf("dials scene shader loop iterations: %.0f\n", g_window.dialsShader_loop_count);		
+	win->dialsShader_loop_count = (float) safeParse(line, max_digits);		
+	printf("dials scene shader loop iterations: %.0f\n", win->dialsShader_loop_count);		
 
 	// read the long/fullscreen quad shader loop count
 	std::getline(infile, line);
-	g_window.longShader_loop_count = (float) safeParse(line, max_digits);
-	printf("long shader loop iterations: %.0f\n", g_window.longShader_loop_count);
+	win->longShader_loop_count = (float) safeParse(line, max_digits);
+	printf("long shader loop iterations: %.0f\n", win->longShader_loop_count);
+
+	// the rest are for the whole process, they only come from the first
+	// surface's params file
+	if(win != &g_window)
+	{
+		return 0;
+	}
 
 	// read number of frames to render
 	std::getline(infile, line);
@@ -756,67 +1092,1429 @@ int read_config_file(char* config_filename)
 	{
 		printf("Number of frames to render: %d\n", g_FramesToRender);
 	}
-	return 0;
-}
-
-// main
-//------------------------------------------------------------------------------
-int main(int argc, char **argv)
-{
-	struct sigaction sigint;
-	struct display display = { 0 };
-	
-	int ret = 0;
-	struct output *iter, *next;
 
-	memset(&g_window, 0, sizeof(g_window) );
+	// a half-written file leaves the remaining lines unread
+	if(reload && infile.fail())
+	{
+		printf("Parameters file is incomplete\n");
+		return -1;
+	}
 
-	g_window.display = &display;
-	display.window = &g_window;
-	g_window.geometry.width  = WINDOW_WIDTH;	// default window dim
-	g_window.geometry.height = WINDOW_HEIGHT;	// default window dim
-	g_window.window_size = g_window.geometry;
-	g_window.buffer_size = 32;	// 32 bpp
-	g_window.frame_sync = 0;
-	g_window.fullscreen = 0;
-	g_recordMetrics = false;
+	// the lines below were added later, older params files without 
+	// them keep the defaults
 
-	// read the config file
-	char* config_filename = NULL;
-	if(argc){
-		config_filename = argv[1];
+	// adaptive run length
+	if(std::getline(infile, line))
+	{
+		g_adaptiveTolerance = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_adaptiveMaxSeconds = safeParse(line, max_digits);
+	}
+	if(g_adaptiveTolerance)
+	{
+		printf("Adaptive run length: tolerance %.1f%%, max %u seconds\n", g_adaptiveTolerance / 10.0, g_adaptiveMaxSeconds);
 	}
-	read_config_file(config_filename);
-	
-	// set up window
-	display.display = wl_display_connect(NULL);
-	assert(display.display);
-	wl_list_init(&display.output_list);
-
-	display.registry = wl_display_get_registry(display.display);
-	wl_registry_add_listener(display.registry,
-				 &registry_listener, &display);
 
-	wl_display_dispatch(display.display);
+	// deterministic simulation time
+	if(std::getline(infile, line))
+	{
+		g_fixedTimestep = safeParse(line, max_digits);
+	}
+	if(g_fixedTimestep)
+	{
+		printf("Fixed simulation timestep: %u microseconds per frame\n", g_fixedTimestep);
+	}
 
+	// what starts the next frame
+	if(std::getline(infile, line))
+	{
+		g_framePacing = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_timerPeriod = safeParse(line, 7);
+	}
+	if(std::getline(infile, line))
+	{
+		g_timerPhase = safeParse(line, 7);
+	}
+	if(g_framePacing > PACING_TIMER)
+	{
+		printf("Unknown frame pacing %u, drawing unthrottled\n", g_framePacing);
+		g_framePacing = PACING_UNTHROTTLED;
+	}
+	if((PACING_TIMER == g_framePacing) && (0 == g_timerPeriod))
+	{
+		printf("Frame timer period can't be 0, drawing unthrottled\n");
+		g_framePacing = PACING_UNTHROTTLED;
+	}
+	if(PACING_FRAME_CALLBACKS == g_framePacing)
+	{
+		printf("Frame pacing: compositor frame callbacks\n");
+	}
+	if(PACING_TIMER == g_framePacing)
+	{
+		printf("Frame pacing: every %u microseconds, phase %u\n", g_timerPeriod, g_timerPhase);
+	}
 
-	// initialize GL
-	init_egl(&display, &g_window);
-	create_surface(&g_window);
-	init_gl(&g_window);
+	// damage tracking stress
+	if(std::getline(infile, line))
+	{
+		g_damageTiles = safeParse(line, max_digits);
+	}
+	if(g_damageTiles)
+	{
+		printf("Damage stress: %u tiles per frame\n", g_damageTiles);
+	}
+	if(std::getline(infile, line))
+	{
+		g_partialRedraw = (safeParse(line, 1) != 0);
+	}
+	if(g_partialRedraw)
+	{
+		printf("Partial redraw from the buffer age\n");
+	}
 
-	display.cursor_surface =
-		wl_compositor_create_surface(display.compositor);
+	// how frames are presented
+	if(std::getline(infile, line))
+	{
+		g_presentMode = safeParse(line, max_digits);
+	}
+	if(g_presentMode >= presentModeCount)
+	{
+		printf("Unknown present mode %u, swapping\n", g_presentMode);
+		g_presentMode = presentSwapDamage;
+	}
+	printf("Present mode: %s\n", present_mode_name(g_presentMode));
 
-	sigint.sa_handler = signal_int;
-	sigemptyset(&sigint.sa_mask);
-	sigint.sa_flags = SA_RESETHAND;
-	sigaction(SIGINT, &sigint, NULL);
+	// window framebuffer format
+	if(std::getline(infile, line))
+	{
+		win->color_format = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		win->depth_size = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		win->stencil_size = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		win->samples = safeParse(line, max_digits);
+	}
+	if(win->color_format >= (int)(sizeof(g_color_formats)/sizeof(g_color_formats[0])))
+	{
+		printf("Unknown color format %d, using %s\n", win->color_format, g_color_formats[0].name);
+		win->color_format = 0;
+	}
+	printf("Window framebuffer: %s, depth %d, stencil %d, samples %d\n",
+		g_color_formats[win->color_format].name, win->depth_size, win->stencil_size, win->samples);
+
+	// surface resize stress
+	if(std::getline(infile, line))
+	{
+		g_resizeStress = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_resizeInterval = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_resizeMinWidth = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_resizeMinHeight = safeParse(line, max_digits, 1);
+	}
+	if(g_resizeStress >= resizeModeCount)
+	{
+		printf("Unknown resize stress mode %u, not resizing\n", g_resizeStress);
+		g_resizeStress = resizeOff;
+	}
+	if(g_resizeStress)
+	{
+		printf("Resize stress: %s sizes every %u frames, down to (%d,%d)\n",
+			(resizeSchedule == g_resizeStress) ? "stepped" : "random",
+			g_resizeInterval, g_resizeMinWidth, g_resizeMinHeight);
+	}
+
+	// offscreen render targets, checked against the driver by offscreen_init()
+	if(std::getline(infile, line))
+	{
+		g_offscreenFormat = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_offscreenDepth = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_offscreenSamples = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_offscreenWidth = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_offscreenHeight = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_offscreenTargets = safeParse(line, max_digits, 1);
+	}
+
+	// frame readback
+	if(std::getline(infile, line))
+	{
+		g_readbackMode = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_readbackInterval = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_readbackDepth = safeParse(line, max_digits, 1);
+	}
+	if(g_readbackMode >= readbackModeCount)
+	{
+		printf("Unknown readback mode %u, not reading back\n", g_readbackMode);
+		g_readbackMode = readbackOff;
+	}
+	if(g_readbackMode)
+	{
+		printf("Readback: %s, every %u frames, %u buffers\n", readback_mode_name(g_readbackMode), g_readbackInterval, g_readbackDepth);
+	}
+
+	// frame check, the golden file is given with --golden
+	if(std::getline(infile, line))
+	{
+		g_frameCheckMode = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_frameCheckInterval = safeParse(line, max_digits, 1);
+	}
+	if(g_frameCheckMode >= frameCheckModeCount)
+	{
+		printf("Unknown frame check mode %u, not checking frames\n", g_frameCheckMode);
+		g_frameCheckMode = frameCheckOff;
+	}
+
+	// frame capture, the file is given with --capture
+	if(std::getline(infile, line))
+	{
+		g_captureMode = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_captureInterval = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_captureQueue = safeParse(line, max_digits, 1);
+	}
+	if(g_captureMode >= captureModeCount)
+	{
+		printf("Unknown capture mode %u, not capturing\n", g_captureMode);
+		g_captureMode = captureOff;
+	}
+
+	// post-process chain scene
+	if(std::getline(infile, line))
+	{
+		g_postDownsample = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_postBlurPasses = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_postBloom = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_postTonemap = safeParse(line, max_digits);
+	}
+	if(g_postDownsample > MAX_POST_DOWNSAMPLES)
+	{
+		printf("At most %d post-process downsamples\n", MAX_POST_DOWNSAMPLES);
+		g_postDownsample = MAX_POST_DOWNSAMPLES;
+	}
+
+	// large texture scene
+	if(std::getline(infile, line))
+	{
+		g_textureRawWidth = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_textureUploadRows = safeParse(line, max_digits);
+	}
+
+	// multi-texture scene
+	if(std::getline(infile, line))
+	{
+		g_multiTextureCount = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_multiTextureSize = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_multiTextureFormat = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_multiTextureFalloff = safeParse(line, max_digits);
+	}
+	if(g_multiTextureCount > MAX_MULTI_TEXTURES)
+	{
+		printf("At most %d multi-texture textures\n", MAX_MULTI_TEXTURES);
+		g_multiTextureCount = MAX_MULTI_TEXTURES;
+	}
+	if(0 != (g_multiTextureSize & (g_multiTextureSize - 1)))
+	{
+		printf("Multi-texture size %u is not a power of two, using 1024\n", g_multiTextureSize);
+		g_multiTextureSize = 1024;
+	}
+	if(g_multiTextureFormat >= multiTextureFormatCount)
+	{
+		printf("Unknown multi-texture format %u, using RGBA8\n", g_multiTextureFormat);
+		g_multiTextureFormat = multiTextureRGBA8;
+	}
+	if(g_multiTextureFalloff > 100)
+	{
+		printf("Multi-texture weight falloff is a percentage, using 100\n");
+		g_multiTextureFalloff = 100;
+	}
+
+	// streaming upload scene
+	if(std::getline(infile, line))
+	{
+		g_streamMode = safeParse(line, max_digits);
+	}
+	if(std::getline(infile, line))
+	{
+		g_streamWidth = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_streamHeight = safeParse(line, max_digits, 1);
+	}
+	if(std::getline(infile, line))
+	{
+		g_streamFormat = safeParse(line, max_digits);
+	}
+	if(g_streamMode >= streamModeCount)
+	{
+		printf("Unknown stream upload mode %u, using double-buffered textures\n", g_streamMode);
+		g_streamMode = streamDouble;
+	}
+	if(g_streamFormat >= streamFormatCount)
+	{
+		printf("Unknown stream upload format %u, using RGBA8\n", g_streamFormat);
+		g_streamFormat = streamRGBA8;
+	}
+
+	return 0;
+}
+
+// copy of every setting read from the params file, so a reload can be 
+// compared against what is currently running
+struct config_snapshot {
+	struct geometry geometry;
+	int fullscreen, offscreen, frame_sync;
+	bool no_swapbuffer_call;
+	bool record_metrics;
+	DrawCases draw_case;
+	bool texture_flat_no_rotate;
+	float texture_fetch_radius;
+	int x_count, y_count, z_count, batch_size;
+	float shortShader_loop_count, dialsShader_loop_count, longShader_loop_count;
+	unsigned int frames_to_render;
+	unsigned int adaptive_tolerance, adaptive_max_seconds;
+	unsigned int fixed_timestep;
+	unsigned int frame_pacing;
+	unsigned int timer_period, timer_phase;
+	unsigned int damage_tiles;
+	bool partial_redraw;
+	unsigned int present_mode;
+	int color_format, depth_size, stencil_size, samples;
+	unsigned int resize_stress, resize_interval;
+	int resize_min_width, resize_min_height;
+	unsigned int offscreen_format, offscreen_depth, offscreen_samples;
+	int offscreen_width, offscreen_height;
+	unsigned int offscreen_targets;
+	unsigned int readback_mode, readback_interval, readback_depth;
+	unsigned int frame_check_mode, frame_check_interval;
+	unsigned int capture_mode, capture_interval, capture_queue;
+	unsigned int post_downsample, post_blur_passes;
+	bool post_bloom, post_tonemap;
+	unsigned int texture_raw_width, texture_upload_rows;
+	unsigned int multi_texture_count, multi_texture_size, multi_texture_format, multi_texture_falloff;
+	unsigned int stream_mode, stream_width, stream_height, stream_format;
+};
+
+//------------------------------------------------------------------------------
+static void save_config(config_snapshot& config)
+{
+	config.geometry = g_window.geometry;
+	config.fullscreen = g_window.fullscreen;
+	config.offscreen = g_window.offscreen;
+	config.frame_sync = g_window.frame_sync;
+	config.no_swapbuffer_call = g_window.no_swapbuffer_call;
+	config.record_metrics = g_recordMetrics;
+	config.draw_case = g_window.draw_case;
+	config.texture_flat_no_rotate = g_window.texture_flat_no_rotate;
+	config.texture_fetch_radius = g_window.texture_fetch_radius;
+	config.x_count = g_window.x_count;
+	config.y_count = g_window.y_count;
+	config.z_count = g_window.z_count;
+	config.batch_size = g_window.batch_size;
+	config.shortShader_loop_count = g_window.shortShader_loop_count;
+	config.dialsShader_loop_count = g_window.dialsShader_loop_count;
+	config.longShader_loop_count = g_window.longShader_loop_count;
+	config.frames_to_render = g_FramesToRender;
+	config.adaptive_tolerance = g_adaptiveTolerance;
+	config.adaptive_max_seconds = g_adaptiveMaxSeconds;
+	config.fixed_timestep = g_fixedTimestep;
+	config.frame_pacing = g_framePacing;
+	config.timer_period = g_timerPeriod;
+	config.timer_phase = g_timerPhase;
+	config.damage_tiles = g_damageTiles;
+	config.partial_redraw = g_partialRedraw;
+	config.present_mode = g_presentMode;
+	config.color_format = g_window.color_format;
+	config.depth_size = g_window.depth_size;
+	config.stencil_size = g_window.stencil_size;
+	config.samples = g_window.samples;
+	config.resize_stress = g_resizeStress;
+	config.resize_interval = g_resizeInterval;
+	config.resize_min_width = g_resizeMinWidth;
+	config.resize_min_height = g_resizeMinHeight;
+	config.offscreen_format = g_offscreenFormat;
+	config.offscreen_depth = g_offscreenDepth;
+	config.offscreen_samples = g_offscreenSamples;
+	config.offscreen_width = g_offscreenWidth;
+	config.offscreen_height = g_offscreenHeight;
+	config.offscreen_targets = g_offscreenTargets;
+	config.readback_mode = g_readbackMode;
+	config.readback_interval = g_readbackInterval;
+	config.readback_depth = g_readbackDepth;
+	config.frame_check_mode = g_frameCheckMode;
+	config.frame_check_interval = g_frameCheckInterval;
+	config.capture_mode = g_captureMode;
+	config.capture_interval = g_captureInterval;
+	config.capture_queue = g_captureQueue;
+	config.post_downsample = g_postDownsample;
+	config.post_blur_passes = g_postBlurPasses;
+	config.post_bloom = g_postBloom;
+	config.post_tonemap = g_postTonemap;
+	config.texture_raw_width = g_textureRawWidth;
+	config.texture_upload_rows = g_textureUploadRows;
+	config.multi_texture_count = g_multiTextureCount;
+	config.multi_texture_size = g_multiTextureSize;
+	config.multi_texture_format = g_multiTextureFormat;
+	config.multi_texture_falloff = g_multiTextureFalloff;
+	config.stream_mode = g_streamMode;
+	config.stream_width = g_streamWidth;
+	config.stream_height = g_streamHeight;
+	config.stream_format = g_streamFormat;
+}
+
+//------------------------------------------------------------------------------
+static void restore_config(const config_snapshot& config)
+{
+	g_window.geometry = config.geometry;
+	g_window.fullscreen = config.fullscreen;
+	g_window.offscreen = config.offscreen;
+	g_window.frame_sync = config.frame_sync;
+	g_window.no_swapbuffer_call = config.no_swapbuffer_call;
+	g_recordMetrics = config.record_metrics;
+	g_window.draw_case = config.draw_case;
+	g_window.texture_flat_no_rotate = config.texture_flat_no_rotate;
+	g_window.texture_fetch_radius = config.texture_fetch_radius;
+	g_window.x_count = config.x_count;
+	g_window.y_count = config.y_count;
+	g_window.z_count = config.z_count;
+	g_window.batch_size = config.batch_size;
+	g_window.shortShader_loop_count = config.shortShader_loop_count;
+	g_window.dialsShader_loop_count = config.dialsShader_loop_count;
+	g_window.longShader_loop_count = config.longShader_loop_count;
+	g_FramesToRender = config.frames_to_render;
+	g_adaptiveTolerance = config.adaptive_tolerance;
+	g_adaptiveMaxSeconds = config.adaptive_max_seconds;
+	g_fixedTimestep = config.fixed_timestep;
+	g_framePacing = config.frame_pacing;
+	g_timerPeriod = config.timer_period;
+	g_timerPhase = config.timer_phase;
+	g_damageTiles = config.damage_tiles;
+	g_partialRedraw = config.partial_redraw;
+	g_presentMode = config.present_mode;
+	g_window.color_format = config.color_format;
+	g_window.depth_size = config.depth_size;
+	g_window.stencil_size = config.stencil_size;
+	g_window.samples = config.samples;
+	g_resizeStress = config.resize_stress;
+	g_resizeInterval = config.resize_interval;
+	g_resizeMinWidth = config.resize_min_width;
+	g_resizeMinHeight = config.resize_min_height;
+	g_offscreenFormat = config.offscreen_format;
+	g_offscreenDepth = config.offscreen_depth;
+	g_offscreenSamples = config.offscreen_samples;
+	g_offscreenWidth = config.offscreen_width;
+	g_offscreenHeight = config.offscreen_height;
+	g_offscreenTargets = config.offscreen_targets;
+	g_readbackMode = config.readback_mode;
+	g_readbackInterval = config.readback_interval;
+	g_readbackDepth = config.readback_depth;
+	g_frameCheckMode = config.frame_check_mode;
+	g_frameCheckInterval = config.frame_check_interval;
+	g_captureMode = config.capture_mode;
+	g_captureInterval = config.capture_interval;
+	g_captureQueue = config.capture_queue;
+	g_postDownsample = config.post_downsample;
+	g_postBlurPasses = config.post_blur_passes;
+	g_postBloom = config.post_bloom;
+	g_postTonemap = config.post_tonemap;
+	g_textureRawWidth = config.texture_raw_width;
+	g_textureUploadRows = config.texture_upload_rows;
+	g_multiTextureCount = config.multi_texture_count;
+	g_multiTextureSize = config.multi_texture_size;
+	g_multiTextureFormat = config.multi_texture_format;
+	g_multiTextureFalloff = config.multi_texture_falloff;
+	g_streamMode = config.stream_mode;
+	g_streamWidth = config.stream_width;
+	g_streamHeight = config.stream_height;
+	g_streamFormat = config.stream_format;
+}
+
+// push the settings that changed since 'old' into the running app
+// EGL, the shaders, the textures and the wayland surface are all kept, only 
+// the state that depends on a changed setting gets rebuilt
+//------------------------------------------------------------------------------
+static void apply_config_changes(window* win, const config_snapshot& old)
+{
+	// these are baked into the surface/egl setup at startup
+	if(win->fullscreen != old.fullscreen)
+	{
+		printf("Fullscreen mode can not be changed while running, keeping %d\n", old.fullscreen);
+		win->fullscreen = old.fullscreen;
+	}
+	if(win->offscreen != old.offscreen)
+	{
+		printf("Offscreen mode can not be changed while running, keeping %d\n", old.offscreen);
+		win->offscreen = old.offscreen;
+	}
+	if((win->color_format != old.color_format) || (win->depth_size != old.depth_size) ||
+		(win->stencil_size != old.stencil_size) || (win->samples != old.samples))
+	{
+		printf("The EGL config can not be changed while running, keeping it\n");
+		win->color_format = old.color_format;
+		win->depth_size = old.depth_size;
+		win->stencil_size = old.stencil_size;
+		win->samples = old.samples;
+	}
+	if(win->no_swapbuffer_call != old.no_swapbuffer_call)
+	{
+		printf("eglSwapBuffers mode can not be changed while running, keeping %d\n", old.no_swapbuffer_call);
+		win->no_swapbuffer_call = old.no_swapbuffer_call;
+	}
+	if(g_framePacing != old.frame_pacing)
+	{
+		printf("Frame pacing can not be changed while running, keeping %u\n", old.frame_pacing);
+		g_framePacing = old.frame_pacing;
+	}
+	if((g_timerPeriod != old.timer_period) || (g_timerPhase != old.timer_phase))
+	{
+		printf("Frame timer can not be changed while running, keeping %u/%u\n", old.timer_period, old.timer_phase);
+		g_timerPeriod = old.timer_period;
+		g_timerPhase = old.timer_phase;
+	}
+	if((g_offscreenFormat != old.offscreen_format) || (g_offscreenDepth != old.offscreen_depth) ||
+		(g_offscreenSamples != old.offscreen_samples) || (g_offscreenWidth != old.offscreen_width) ||
+		(g_offscreenHeight != old.offscreen_height) || (g_offscreenTargets != old.offscreen_targets))
+	{
+		printf("Offscreen targets can not be changed while running, keeping the current ones\n");
+		g_offscreenFormat = old.offscreen_format;
+		g_offscreenDepth = old.offscreen_depth;
+		g_offscreenSamples = old.offscreen_samples;
+		g_offscreenWidth = old.offscreen_width;
+		g_offscreenHeight = old.offscreen_height;
+		g_offscreenTargets = old.offscreen_targets;
+	}
+	if((g_frameCheckMode != old.frame_check_mode) || (g_frameCheckInterval != old.frame_check_interval))
+	{
+		printf("Frame check can not be changed while running, keeping %u/%u\n", old.frame_check_mode, old.frame_check_interval);
+		g_frameCheckMode = old.frame_check_mode;
+		g_frameCheckInterval = old.frame_check_interval;
+	}
+	if((g_captureMode != old.capture_mode) || (g_captureInterval != old.capture_interval) ||
+		(g_captureQueue != old.capture_queue))
+	{
+		printf("Frame capture can not be changed while running, keeping %u/%u/%u\n", old.capture_mode, old.capture_interval, old.capture_queue);
+		g_captureMode = old.capture_mode;
+		g_captureInterval = old.capture_interval;
+		g_captureQueue = old.capture_queue;
+	}
+
+	// window size - the compositor owns the size of fullscreen surfaces
+	if((win->geometry.width != old.geometry.width) || (win->geometry.height != old.geometry.height))
+	{
+		if(win->fullscreen)
+		{
+			printf("Window size can not be changed in fullscreen mode\n");
+			win->geometry = old.geometry;
+		}
+		else
+		{
+			printf("Resizing window to (%d,%d)\n", win->geometry.width, win->geometry.height);
+			win->window_size = win->geometry;
+			resize_surface(win, win->geometry.width, win->geometry.height);
+		}
+	}
+
+	if(g_presentMode >= presentModeCount)
+	{
+		printf("Unknown present mode %u, keeping %s\n", g_presentMode, present_mode_name(old.present_mode));
+		g_presentMode = old.present_mode;
+	}
+
+	// the resize stress picks up its settings on the next frame
+	if(g_resizeStress >= resizeModeCount)
+	{
+		printf("Unknown resize stress mode %u, keeping %u\n", g_resizeStress, old.resize_stress);
+		g_resizeStress = old.resize_stress;
+	}
+	if(g_readbackMode >= readbackModeCount)
+	{
+		printf("Unknown readback mode %u, keeping %s\n", g_readbackMode, readback_mode_name(old.readback_mode));
+		g_readbackMode = old.readback_mode;
+	}
+
+	// the post-process scene picks up its settings on the next frame
+	if(g_postDownsample > MAX_POST_DOWNSAMPLES)
+	{
+		printf("At most %d post-process downsamples, keeping %u\n", MAX_POST_DOWNSAMPLES, old.post_downsample);
+		g_postDownsample = old.post_downsample;
+	}
+
+	// the large texture is read once, the first time its scene is drawn
+	if(((g_textureRawWidth != old.texture_raw_width) || (g_textureUploadRows != old.texture_upload_rows)) &&
+		largeTexture_loaded())
+	{
+		printf("The large texture is already loaded, keeping raw width %u and upload rows %u\n", old.texture_raw_width, old.texture_upload_rows);
+		g_textureRawWidth = old.texture_raw_width;
+		g_textureUploadRows = old.texture_upload_rows;
+	}
+
+	// the multi-texture scene remakes its textures on the next frame
+	if((g_multiTextureCount < 1) || (g_multiTextureCount > MAX_MULTI_TEXTURES))
+	{
+		printf("Multi-texture count must be between 1 and %d, keeping %u\n", MAX_MULTI_TEXTURES, old.multi_texture_count);
+		g_multiTextureCount = old.multi_texture_count;
+	}
+	if((0 == g_multiTextureSize) || (0 != (g_multiTextureSize & (g_multiTextureSize - 1))))
+	{
+		printf("Multi-texture size must be a power of two, keeping %u\n", old.multi_texture_size);
+		g_multiTextureSize = old.multi_texture_size;
+	}
+	if(g_multiTextureFormat >= multiTextureFormatCount)
+	{
+		printf("Unknown multi-texture format %u, keeping %s\n", g_multiTextureFormat, multi_texture_format_name(old.multi_texture_format));
+		g_multiTextureFormat = old.multi_texture_format;
+	}
+	if(g_multiTextureFalloff > 100)
+	{
+		printf("Multi-texture weight falloff is a percentage, keeping %u\n", old.multi_texture_falloff);
+		g_multiTextureFalloff = old.multi_texture_falloff;
+	}
+	if((multiTexture == win->draw_case) && (old.draw_case == win->draw_case) &&
+		((g_multiTextureCount != old.multi_texture_count) || (g_multiTextureSize != old.multi_texture_size) ||
+		(g_multiTextureFormat != old.multi_texture_format) || (g_multiTextureFalloff != old.multi_texture_falloff)))
+	{
+		print_draw_case(win);
+	}
+
+	// the streaming upload scene starts over on the next frame
+	if(g_streamMode >= streamModeCount)
+	{
+		printf("Unknown stream upload mode %u, keeping %s\n", g_streamMode, stream_mode_name(old.stream_mode));
+		g_streamMode = old.stream_mode;
+	}
+	if(g_streamFormat >= streamFormatCount)
+	{
+		printf("Unknown stream upload format %u, keeping %s\n", g_streamFormat, stream_format_name(old.stream_format));
+		g_streamFormat = old.stream_format;
+	}
+	if((postProcess == win->draw_case) && (old.draw_case == win->draw_case) &&
+		((g_postDownsample != old.post_downsample) || (g_postBlurPasses != old.post_blur_passes) ||
+		(g_postBloom != old.post_bloom) || (g_postTonemap != old.post_tonemap)))
+	{
+		print_draw_case(win);
+	}
+
+	if(g_recordMetrics != old.record_metrics)
+	{
+		bool enable = g_recordMetrics;
+		g_recordMetrics = old.record_metrics;
+		change_metrics_recording(enable);
+	}
+
+	// frame callbacks or the frame timer pace the loop, the swap interval stays 0
+	if((win->frame_sync != old.frame_sync) && !win->headless && (PACING_UNTHROTTLED == g_framePacing))
+	{
+		eglSwapInterval(win->display->egl.dpy, win->frame_sync ? 1 : 0);
+	}
+
+	// only rebuild the pyramid meshes if the grid actually changed
+	if((win->x_count != old.x_count) || (win->y_count != old.y_count) || (win->z_count != old.z_count))
+	{
+		generate_pyramid_buffers(win);
+	}
+
+	// frames measured with the old settings don't count
+	adaptive_run_configure(g_adaptiveTolerance, g_adaptiveMaxSeconds);
+}
+
+// the params file settings by name, in params file order
+enum param_type {
+	param_int,
+	param_uint,
+	param_float,
+	param_bool,
+	param_scene,
+};
+
+struct named_param {
+	const char* name;
+	param_type type;
+	void* value;
+	int max_digits;
+	int minvalue;
+};
+
+static const named_param g_named_params[] = {
+	{ "width",				param_int,		&g_window.geometry.width,			5, 0 },
+	{ "height",				param_int,		&g_window.geometry.height,			5, 0 },
+	{ "fullscreen",			param_int,		&g_window.fullscreen,				1, 0 },
+	{ "metrics",			param_bool,		&g_recordMetrics,					1, 0 },
+	{ "offscreen",			param_int,		&g_window.offscreen,				1, 0 },
+	{ "vsync",				param_int,		&g_window.frame_sync,				1, 0 },
+	{ "no_swapbuffers",		param_bool,		&g_window.no_swapbuffer_call,		1, 0 },
+	{ "scene",				param_scene,	&g_window.draw_case,				1, 0 },
+	{ "flat_shader",		param_bool,		&g_window.texture_flat_no_rotate,	1, 0 },
+	{ "blur_radius",		param_float,	&g_window.texture_fetch_radius,		5, 1 },
+	{ "pyramids_x",			param_int,		&g_window.x_count,					5, 1 },
+	{ "pyramids_y",			param_int,		&g_window.y_count,					5, 1 },
+	{ "pyramids_z",			param_int,		&g_window.z_count,					5, 1 },
+	{ "batches",			param_int,		&g_window.batch_size,				5, 1 },
+	{ "pyramid_loops",		param_float,	&g_window.shortShader_loop_count,	5, 0 },
+	{ "dials_loops",		param_float,	&g_window.dialsShader_loop_count,	5, 0 },
+	{ "longshader_loops",	param_float,	&g_window.longShader_loop_count,	5, 0 },
+	{ "frames",				param_uint,		&g_FramesToRender,					5, 0 },
+	{ "adaptive_tolerance",	param_uint,		&g_adaptiveTolerance,				5, 0 },
+	{ "adaptive_max_seconds",param_uint,	&g_adaptiveMaxSeconds,				5, 0 },
+	{ "fixed_timestep_us",	param_uint,		&g_fixedTimestep,					5, 0 },
+	{ "frame_pacing",		param_uint,		&g_framePacing,						1, 0 },
+	{ "timer_period_us",	param_uint,		&g_timerPeriod,						7, 1 },
+	{ "timer_phase_us",		param_uint,		&g_timerPhase,						7, 0 },
+	{ "damage_tiles",		param_uint,		&g_damageTiles,						4, 0 },
+	{ "partial_redraw",		param_bool,		&g_partialRedraw,					1, 0 },
+	{ "present",			param_uint,		&g_presentMode,						1, 0 },
+	{ "color_format",		param_int,		&g_window.color_format,				1, 0 },
+	{ "depth_bits",			param_int,		&g_window.depth_size,				2, 0 },
+	{ "stencil_bits",		param_int,		&g_window.stencil_size,				1, 0 },
+	{ "msaa_samples",		param_int,		&g_window.samples,					2, 0 },
+	{ "resize_stress",		param_uint,		&g_resizeStress,					1, 0 },
+	{ "resize_interval",	param_uint,		&g_resizeInterval,					5, 1 },
+	{ "resize_min_width",	param_int,		&g_resizeMinWidth,					5, 1 },
+	{ "resize_min_height",	param_int,		&g_resizeMinHeight,					5, 1 },
+	{ "offscreen_format",	param_uint,		&g_offscreenFormat,					1, 0 },
+	{ "offscreen_depth",	param_uint,		&g_offscreenDepth,					2, 0 },
+	{ "offscreen_samples",	param_uint,		&g_offscreenSamples,				2, 0 },
+	{ "offscreen_width",	param_int,		&g_offscreenWidth,					5, 0 },
+	{ "offscreen_height",	param_int,		&g_offscreenHeight,					5, 0 },
+	{ "offscreen_targets",	param_uint,		&g_offscreenTargets,				2, 1 },
+	{ "readback",			param_uint,		&g_readbackMode,					1, 0 },
+	{ "readback_interval",	param_uint,		&g_readbackInterval,				5, 1 },
+	{ "readback_depth",		param_uint,		&g_readbackDepth,					1, 1 },
+	{ "frame_check",		param_uint,		&g_frameCheckMode,					1, 0 },
+	{ "frame_check_interval",param_uint,	&g_frameCheckInterval,				5, 1 },
+	{ "capture",			param_uint,		&g_captureMode,						1, 0 },
+	{ "capture_interval",	param_uint,		&g_captureInterval,					5, 1 },
+	{ "capture_queue",		param_uint,		&g_captureQueue,					2, 1 },
+	{ "post_downsample",	param_uint,		&g_postDownsample,					1, 0 },
+	{ "post_blur_passes",	param_uint,		&g_postBlurPasses,					2, 0 },
+	{ "post_bloom",			param_bool,		&g_postBloom,						1, 0 },
+	{ "post_tonemap",		param_bool,		&g_postTonemap,						1, 0 },
+	{ "texture_raw_width",	param_uint,		&g_textureRawWidth,					5, 0 },
+	{ "texture_upload_rows",param_uint,		&g_textureUploadRows,				5, 0 },
+	{ "multi_texture_count",param_uint,		&g_multiTextureCount,				2, 1 },
+	{ "multi_texture_size",	param_uint,		&g_multiTextureSize,				5, 1 },
+	{ "multi_texture_format",param_uint,	&g_multiTextureFormat,				1, 0 },
+	{ "multi_texture_falloff",param_uint,	&g_multiTextureFalloff,				3, 0 },
+	{ "stream_mode",		param_uint,		&g_streamMode,						1, 0 },
+	{ "stream_width",		param_uint,		&g_streamWidth,						5, 1 },
+	{ "stream_height",		param_uint,		&g_streamHeight,					5, 1 },
+	{ "stream_format",		param_uint,		&g_streamFormat,					1, 0 },
+};
+
+//------------------------------------------------------------------------------
+static const named_param* find_parameter(const char* name)
+{
+	for(unsigned int i=0; i<sizeof(g_named_params)/sizeof(g_named_params[0]); i++)
+	{
+		if(0 == strcmp(name, g_named_params[i].name))
+		{
+			return &g_named_params[i];
+		}
+	}
+	return NULL;
+}
+
+// parse and store a single parameter without applying it
+// returns 0 on success, -1 for an unknown name and -2 for an invalid value
+//------------------------------------------------------------------------------
+static int store_parameter(const char* name, const char* value)
+{
+	const named_param* param = find_parameter(name);
+	if(!param)
+	{
+		return -1;
+	}
+
+	if(!isdigit((unsigned char)value[0]))
+	{
+		return -2;
+	}
+
+	std::string line(value);
+	int parsed = safeParse(line, param->max_digits, param->minvalue);
+
+	switch(param->type)
+	{
+		case param_int:
+			*(int*)param->value = parsed;
+			break;
+		case param_uint:
+			*(unsigned int*)param->value = parsed;
+			break;
+		case param_float:
+			*(float*)param->value = (float)parsed;
+			break;
+		case param_bool:
+			*(bool*)param->value = (0 != parsed);
+			break;
+		case param_scene:
+			if(!draw_case_valid(parsed))
+			{
+				return -2;
+			}
+			*(DrawCases*)param->value = (DrawCases)parsed;
+			break;
+	}
+	return 0;
+}
+
+// set a single parameter by name, parsed the same way as the params file
+// returns 0 on success, -1 for an unknown name and -2 for an invalid value
+//------------------------------------------------------------------------------
+int set_parameter(window* win, const char* name, const char* value)
+{
+	pthread_rwlock_wrlock(&g_configLock);
+
+	config_snapshot old;
+	save_config(old);
+
+	int result = store_parameter(name, value);
+	if(result)
+	{
+		pthread_rwlock_unlock(&g_configLock);
+		return result;
+	}
+
+	apply_config_changes(win, old);
+	if(win->draw_case != old.draw_case)
+	{
+		print_draw_case(win);
+	}
+	pthread_rwlock_unlock(&g_configLock);
+	return 0;
+}
+
+// set a space separated list of name=value parameters and apply them in one
+// go, so the pyramid meshes are rebuilt at most once
+// returns 0 on success, -1 for an unknown name and -2 for an invalid value,
+// in which case none of the parameters are changed
+//------------------------------------------------------------------------------
+int set_parameters(window* win, const char* settings)
+{
+	pthread_rwlock_wrlock(&g_configLock);
+
+	config_snapshot old;
+	save_config(old);
+
+	std::istringstream list(settings);
+	std::string setting;
+	while(list >> setting)
+	{
+		size_t split = setting.find('=');
+		if(std::string::npos == split)
+		{
+			restore_config(old);
+			pthread_rwlock_unlock(&g_configLock);
+			return -2;
+		}
+
+		std::string name = setting.substr(0, split);
+		std::string value = setting.substr(split + 1);
+		int result = store_parameter(name.c_str(), value.c_str());
+		if(result)
+		{
+			printf("Invalid parameter setting: %s\n", setting.c_str());
+			restore_config(old);
+			pthread_rwlock_unlock(&g_configLock);
+			return result;
+		}
+	}
+
+	apply_config_changes(win, old);
+	if(win->draw_case != old.draw_case)
+	{
+		print_draw_case(win);
+	}
+	pthread_rwlock_unlock(&g_configLock);
+	return 0;
+}
+
+// read a single parameter by name
+//------------------------------------------------------------------------------
+bool get_parameter(const char* name, std::string& value)
+{
+	const named_param* param = find_parameter(name);
+	if(!param)
+	{
+		return false;
+	}
+
+	// big enough for any float the parameters can hold
+	char text[64];
+	switch(param->type)
+	{
+		case param_int:
+			snprintf(text, sizeof(text), "%d", *(int*)param->value);
+			break;
+		case param_uint:
+			snprintf(text, sizeof(text), "%u", *(unsigned int*)param->value);
+			break;
+		case param_float:
+			snprintf(text, sizeof(text), "%.0f", *(float*)param->value);
+			break;
+		case param_bool:
+			snprintf(text, sizeof(text), "%d", *(bool*)param->value ? 1 : 0);
+			break;
+		case param_scene:
+			snprintf(text, sizeof(text), "%d", *(DrawCases*)param->value);
+			break;
+	}
+	value = text;
+	return true;
+}
+
+// space separated list of all parameter names
+//------------------------------------------------------------------------------
+std::string list_parameters()
+{
+	std::string list;
+	for(unsigned int i=0; i<sizeof(g_named_params)/sizeof(g_named_params[0]); i++)
+	{
+		if(i)
+		{
+			list += " ";
+		}
+		list += g_named_params[i].name;
+	}
+	return list;
+}
+
+// stop the main loop, the app shuts down after the current frame
+//------------------------------------------------------------------------------
+void request_exit()
+{
+	running = 0;
+}
+
+// draw one frame of the surface's scene
+//------------------------------------------------------------------------------
+static void draw_scene(window* win, struct wl_callback* callback = NULL, uint32_t time = 0)
+{
+	pthread_rwlock_rdlock(&g_configLock);
+
+	resize_stress_frame(win);
+
+	switch(win->draw_case)
+	{
+		case singleDrawArrays:
+			draw_singleDrawArrays(win, callback, time);
+			break;
+
+		case multiDrawArrays:
+			draw_multiDrawArrays(win, callback, time);
+			break;
+		case simpleTexture:
+			draw_simpleTexture(win, callback, time);
+			break;
+
+		case simpleDial:
+			draw_simpleDial(win, callback, time);
+			break;
+
+		case longShader:
+			draw_longShader(win, callback, time);
+			break;
+
+		case batchDrawArrays:
+			draw_batchDrawArrays(win, callback, time);
+			break;
+
+		case multiTexture:
+			draw_multiTexture(win, callback, time);
+			break;
+
+		case largeTexture:
+			draw_largeTexture(win, callback, time);
+			break;
+
+		case postProcess:
+			draw_postProcess(win, callback, time);
+			break;
+
+		case streamUpload:
+			draw_streamUpload(win, callback, time);
+			break;
+
+		default:
+			printf("Invalid draw case\n");
+			assert(0);
+			break;
+	}
+
+	pthread_rwlock_unlock(&g_configLock);
+}
+
+// bind the shared context to the surface being drawn, when one context
+// draws all the surfaces
+//------------------------------------------------------------------------------
+static void bind_shared_context(window* win)
+{
+	if((g_surface_count > 1) && !g_threaded)
+	{
+		eglMakeCurrent(win->display->egl.dpy, win->egl_surface, win->egl_surface, win->display->egl.ctx);
+		glViewport(0, 0, win->geometry.width, win->geometry.height);
+	}
+}
+
+static void frame_done(void* data, struct wl_callback* callback, uint32_t time);
+
+static const struct wl_callback_listener frame_listener = {
+	frame_done
+};
+
+// the compositor is ready for the next frame of the surface, a NULL
+// callback starts the chain. The next callback is requested before the
+// scene's swap commits the surface, so it belongs to the frame drawn here
+//------------------------------------------------------------------------------
+static void frame_done(void* data, struct wl_callback* callback, uint32_t time)
+{
+	window* win = (window*)data;
+
+	struct wl_callback* next = wl_surface_frame(win->surface);
+	if(win->queue)
+	{
+		wl_proxy_set_queue((struct wl_proxy*)next, win->queue);
+	}
+	wl_callback_add_listener(next, &frame_listener, win);
+
+	bind_shared_context(win);
+	draw_scene(win, callback, time);
+	win->callback = next;
+}
+
+// sleep until wayland events arrive on 'queue' (NULL is the default queue),
+// or the timeout expires, then dispatch them. Unlike wl_display_dispatch()
+// this never blocks for longer than the timeout
+//------------------------------------------------------------------------------
+static void dispatch_display_events(struct wl_display* dpy, struct wl_event_queue* queue, int timeout_ms)
+{
+	while(0 != (queue ? wl_display_prepare_read_queue(dpy, queue) : wl_display_prepare_read(dpy)))
+	{
+		if(queue)
+		{
+			wl_display_dispatch_queue_pending(dpy, queue);
+		}
+		else
+		{
+			wl_display_dispatch_pending(dpy);
+		}
+	}
+	wl_display_flush(dpy);
+
+	struct pollfd pfd;
+	pfd.fd = wl_display_get_fd(dpy);
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if(poll(&pfd, 1, timeout_ms) > 0)
+	{
+		wl_display_read_events(dpy);
+	}
+	else
+	{
+		wl_display_cancel_read(dpy);
+	}
+
+	if(queue)
+	{
+		wl_display_dispatch_queue_pending(dpy, queue);
+	}
+	else
+	{
+		wl_display_dispatch_pending(dpy);
+	}
+}
+
+// an extra surface uses the programs and textures that init_gl() created
+// for the first surface, they live in the same context; only the pyramid
+// meshes and the post-process targets follow the surface's own size
+//------------------------------------------------------------------------------
+static void share_gl_resources(window* win, const window* first)
+{
+	win->gl_single = first->gl_single;
+	win->gl_multi = first->gl_multi;
+	win->gl_tex = first->gl_tex;
+	win->gl_tex_blur = first->gl_tex_blur;
+	win->gl_flat = first->gl_flat;
+	win->gl_longShader = first->gl_longShader;
+
+	generate_pyramid_buffers(win);
+	initialize_postProcess(win);
+	initialize_multiTexture(win);
+}
+
+// an extra surface with its own thread and context, it compiles its own
+// programs (uniform values are per program, so they can't be shared between
+// threads) and uses the textures the first surface created in the share group
+//------------------------------------------------------------------------------
+static void* render_thread(void* data)
+{
+	window* win = (window*)data;
+	display* display = win->display;
+
+	if(!eglMakeCurrent(display->egl.dpy, win->egl_surface, win->egl_surface, win->egl_context))
+	{
+		printf("Surface %d: eglMakeCurrent() failed 0x%x\n", win->surface_index, eglGetError());
+		return NULL;
+	}
+	if(!win->frame_sync)
+	{
+		eglSwapInterval(display->egl.dpy, 0);
+	}
+	init_gl(win);
+
+	if(PACING_FRAME_CALLBACKS == g_framePacing)
+	{
+		// the thread's frame callbacks arrive on its own queue, so it
+		// never dispatches another surface's events
+		win->queue = wl_display_create_queue(display->display);
+		frame_done(win, NULL, 0);
+		while(running)
+		{
+			dispatch_display_events(display->display, win->queue, EVENT_POLL_TIMEOUT_MS);
+		}
+		if(win->callback)
+		{
+			wl_callback_destroy(win->callback);
+			win->callback = NULL;
+		}
+		wl_event_queue_destroy(win->queue);
+		win->queue = NULL;
+	}
+	else if(PACING_TIMER == g_framePacing)
+	{
+		// every thread has its own timer, on the same deadlines
+		frame_timer timer;
+		if(frame_timer_start(timer, g_timerPeriod, g_timerPhase))
+		{
+			while(running)
+			{
+				if(frame_timer_wait(timer, EVENT_POLL_TIMEOUT_MS))
+				{
+					win->start_lateness_us = frame_timer_lateness_us(timer);
+					draw_scene(win);
+				}
+			}
+		}
+		frame_timer_stop(timer, win->surface_index);
+	}
+	else
+	{
+		while(running)
+		{
+			draw_scene(win);
+		}
+	}
+	readback_stop(win);
+	stream_upload_stop(win);
+
+	eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglReleaseThread();
+	return NULL;
+}
+
+// re-read the params file and apply whatever changed
+//------------------------------------------------------------------------------
+void reload_config_file(window* win)
+{
+	pthread_rwlock_wrlock(&g_configLock);
+
+	config_snapshot old;
+	save_config(old);
+
+	printf("Parameters file changed, reloading...\n");
+	if(read_config_file(&g_window, g_config_filename, true))
+	{
+		printf("Keeping the current parameters\n");
+		restore_config(old);
+	}
+	else
+	{
+		apply_config_changes(win, old);
+	}
+
+	pthread_rwlock_unlock(&g_configLock);
+}
+
+// main
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	struct sigaction sigint;
+	struct display display = { 0 };
+	
+	int ret = 0;
+	struct output *iter, *next;
+
+	memset(&g_window, 0, sizeof(g_window) );
+
+	g_window.display = &display;
+	display.window = &g_window;
+	g_window.geometry.width  = WINDOW_WIDTH;	// default window dim
+	g_window.geometry.height = WINDOW_HEIGHT;	// default window dim
+	g_window.window_size = g_window.geometry;
+	g_window.buffer_size = 32;	// 32 bpp
+	g_window.depth_size = 24;
+	g_window.frame_sync = 0;
+	g_window.fullscreen = 0;
+	g_recordMetrics = false;
+
+	// read the command line
+	std::vector<char*> config_filenames;
+	char* control_path = NULL;
+	const char* golden_filename = "golden.txt";
+	const char* capture_filename = NULL;
+	bool run_suite = false;
+	bool headless = false;
+	int surface_count = 0;
+	for(int i=1; i<argc; i++)
+	{
+		if((0 == strcmp(argv[i], "--control")) && (i+1 < argc))
+		{
+			control_path = argv[++i];
+		}
+		else if((0 == strcmp(argv[i], "--golden")) && (i+1 < argc))
+		{
+			golden_filename = argv[++i];
+		}
+		else if((0 == strcmp(argv[i], "--capture")) && (i+1 < argc))
+		{
+			capture_filename = argv[++i];
+		}
+		else if((0 == strcmp(argv[i], "--texture")) && (i+1 < argc))
+		{
+			set_largeTexture_file(argv[++i]);
+		}
+		else if((0 == strcmp(argv[i], "--surfaces")) && (i+1 < argc))
+		{
+			surface_count = atoi(argv[++i]);
+			if((surface_count < 1) || (surface_count > MAX_SURFACES))
+			{
+				printf("--surfaces must be between 1 and %d\n", MAX_SURFACES);
+				exit(1);
+			}
+		}
+		else if(0 == strcmp(argv[i], "--suite"))
+		{
+			run_suite = true;
+		}
+		else if(0 == strcmp(argv[i], "--headless"))
+		{
+			headless = true;
+		}
+		else if(0 == strcmp(argv[i], "--threads"))
+		{
+			g_threaded = true;
+		}
+		else if(0 == strncmp(argv[i], "--", 2))
+		{
+			printf("Unknown option: %s\n", argv[i]);
+			printf("Usage: %s [--suite] [--headless] [--surfaces <count>] [--threads] [--control <socket path>] [--golden <file>] [--capture <file>] [--texture <file>] [params file...]\n", argv[0]);
+			exit(1);
+		}
+		else
+		{
+			config_filenames.push_back(argv[i]);
+		}
+	}
+
+	// one surface per params file, unless a count is given, then the
+	// params files are used in turn
+	if(0 == surface_count) {
+		surface_count = std::max((int)config_filenames.size(), 1);
+	}
+	char* config_filename = config_filenames.empty() ? NULL : config_filenames[0];
+
+	// read the config file
+	read_config_file(&g_window, config_filename);
+	if(config_filename) {
+		g_config_filename = config_filename;
+	}
+	g_surfaces[g_surface_count++] = &g_window;
+	// headless always draws into the offscreen buffer, at the params file size
+	if(headless) {
+		g_window.headless = true;
+		g_window.offscreen = 1;
+		g_window.fullscreen = 0;
+	}
+	if(run_suite) {
+		suite_prepare(&g_window);
+	}
+	// frame callbacks need a compositor and a swap that commits the surface
+	if((PACING_FRAME_CALLBACKS == g_framePacing) &&
+		(g_window.headless || g_window.no_swapbuffer_call || (g_presentMode > presentSwap))) {
+		printf("Frame callbacks need eglSwapBuffers on a Wayland surface, drawing unthrottled\n");
+		g_framePacing = PACING_UNTHROTTLED;
+	}
+	// the compositor or the timer paces the frames, the swap itself must
+	// not block
+	if(PACING_UNTHROTTLED != g_framePacing) {
+		g_window.frame_sync = 0;
+	}
+	frame_check_start(golden_filename);
+	capture_start(capture_filename);
+	
+	if(g_window.headless) {
+		init_headless_egl(&display, &g_window);
+	} else {
+		// set up window
+		display.display = wl_display_connect(NULL);
+		if(!display.display) {
+			printf("Could not connect to a Wayland compositor, use --headless to run without one\n");
+			exit(1);
+		}
+		wl_list_init(&display.output_list);
+
+		display.registry = wl_display_get_registry(display.display);
+		wl_registry_add_listener(display.registry,
+					 &registry_listener, &display);
+
+		wl_display_dispatch(display.display);
+
+		// initialize EGL
+		init_egl(&display, &g_window);
+		create_surface(&g_window);
+	}
+
+	// initialize GL
+	init_gl(&g_window);
+
+	// the extra surfaces share the first surface's context, or with
+	// --threads, its share group
+	if((surface_count > 1) && (g_window.headless || g_window.offscreen)) {
+		printf("More than one surface needs onscreen Wayland surfaces\n");
+		exit(1);
+	}
+	for(int i=1; i<surface_count; i++) {
+		window* win = new window;
+		memset(win, 0, sizeof(*win));
+		win->display = &display;
+		win->buffer_size = g_window.buffer_size;
+		win->surface_index = i;
+
+		printf("Surface %d:\n", i);
+		read_config_file(win, config_filenames.empty() ? NULL : config_filenames[i % config_filenames.size()]);
+		if(win->offscreen) {
+			printf("Offscreen is only supported on the first surface\n");
+			win->offscreen = 0;
+		}
+		if(PACING_UNTHROTTLED != g_framePacing) {
+			win->frame_sync = 0;
+		}
+
+		create_surface(win);
+		if(g_threaded) {
+			win->egl_context = create_gles_context(&display, display.egl.ctx);
+			if(EGL_NO_CONTEXT == win->egl_context) {
+				printf("Surface %d: eglCreateContext() failed 0x%x\n", i, eglGetError());
+				exit(1);
+			}
+		} else {
+			share_gl_resources(win, &g_window);
+		}
+		g_surfaces[g_surface_count++] = win;
+	}
+
+	// the main thread keeps drawing the first surface, every other surface
+	// gets a render thread, so the GPU has to arbitrate between contexts
+	if(g_threaded && (g_surface_count > 1)) {
+		eglMakeCurrent(display.egl.dpy, g_window.egl_surface, g_window.egl_surface, display.egl.ctx);
+
+		// the shared textures must be complete before another context uses them
+		glFinish();
+
+		for(int i=1; i<g_surface_count; i++) {
+			if(pthread_create(&g_render_threads[i], NULL, render_thread, g_surfaces[i])) {
+				printf("Surface %d: could not start a render thread\n", i);
+				exit(1);
+			}
+		}
+		printf("%d render threads started\n", g_surface_count - 1);
+	}
+
+	if(!g_window.headless) {
+		display.cursor_surface =
+			wl_compositor_create_surface(display.compositor);
+	}
+
+	sigint.sa_handler = signal_int;
+	sigemptyset(&sigint.sa_mask);
+	sigint.sa_flags = SA_RESETHAND;
+	sigaction(SIGINT, &sigint, NULL);
 
 
 	// prime the egl swap buffers 
 	// not sure why this is necissary - shouldn't be
-	if(!g_window.no_swapbuffer_call) {
+	if(g_window.headless) {
+		printf("Headless, frames end with %s\n", (presentReadback == g_presentMode) ? "glReadPixels()" : "glFinish()");
+	} else if(!g_window.no_swapbuffer_call) {
 		eglSwapBuffers(display.egl.dpy, g_window.egl_surface);
 		eglSwapBuffers(display.egl.dpy, g_window.egl_surface);
 		eglSwapBuffers(display.egl.dpy, g_window.egl_surface);
@@ -824,58 +2522,163 @@ int main(int argc, char **argv)
 		printf("Skipping all eglSwapBuffer calls\n");
 	}
 
+	// stop on statistically stable results instead of a frame count
+	adaptive_run_configure(g_adaptiveTolerance, g_adaptiveMaxSeconds);
+
+	// the suite runs fixed workloads, edits to the params file don't apply
+	if(run_suite) {
+		suite_start(&g_window);
+	} else {
+		// pick up edits to the params file without restarting
+		param_watch_init(g_config_filename);
+	}
+
+	// remote control from test orchestrators
+	if(control_path) {
+		control_socket_init(control_path);
+	}
+
+
+	// with frame callbacks every surface draws its first frame now, the
+	// next ones are drawn from the callbacks
+	if(PACING_FRAME_CALLBACKS == g_framePacing)
+	{
+		printf("Drawing on compositor frame callbacks\n");
+		for(int i=0; i<g_surface_count; i++)
+		{
+			if(!g_surfaces[i]->egl_context)
+			{
+				frame_done(g_surfaces[i], NULL, 0);
+			}
+		}
+	}
+
+	// the main thread's timer, it paces all the surfaces it draws
+	frame_timer timer;
+	if((PACING_TIMER == g_framePacing) && !frame_timer_start(timer, g_timerPeriod, g_timerPhase))
+	{
+		exit(1);
+	}
 
 	/* The mainloop here is a little subtle.  Redrawing will cause
 	 * EGL to read events so we can just call
 	 * wl_display_dispatch_pending() to handle any events that got
-	 * queued up as a side effect. */
-	 unsigned int loop_count = 0;
+	 * queued up as a side effect. With frame callbacks nothing is drawn
+	 * until the compositor asks for it, so the loop sleeps in poll()
+	 * on the display fd instead. The frame timer sleeps on the timerfd
+	 * and only picks up the wayland events that already arrived. */
+	uint64_t measured_frame_id = 0;
 	while (running && ret != -1) {
-		wl_display_dispatch_pending(display.display);
+		bool draw = true;
+		if(PACING_FRAME_CALLBACKS == g_framePacing) {
+			dispatch_display_events(display.display, NULL, EVENT_POLL_TIMEOUT_MS);
+		} else if(PACING_TIMER == g_framePacing) {
+			if(!g_window.headless) {
+				dispatch_display_events(display.display, NULL, 0);
+			}
+			draw = frame_timer_wait(timer, EVENT_POLL_TIMEOUT_MS);
+		} else if(!g_window.headless) {
+			wl_display_dispatch_pending(display.display);
+		}
+
+		if(param_watch_changed())
+		{
+			reload_config_file(&g_window);
+		}
+		control_socket_service(&g_window);
 
-		if(0!=g_FramesToRender)
+		// the adaptive run length decides by itself when to stop
+		if((0!=g_FramesToRender) && (0==g_adaptiveTolerance))
 		{
-			if(loop_count > g_FramesToRender){
+			if(g_window.frame_id > g_FramesToRender){
 				running = 0;
 			}
 		}
-		loop_count++;
 
-		switch(g_draw_case)
+		if(draw && (PACING_FRAME_CALLBACKS != g_framePacing))
 		{
-			case singleDrawArrays:
-				draw_singleDrawArrays(&g_window, NULL, 0);
-				break;
-
-			case multiDrawArrays:
-				draw_multiDrawArrays(&g_window, NULL, 0);
-				break;
-			case simpleTexture:
-				draw_simpleTexture(&g_window, NULL, 0);
-				break;
+			for(int i=0; i<g_surface_count; i++)
+			{
+				window* win = g_surfaces[i];
 
-			case simpleDial:
-				draw_simpleDial(&g_window, NULL, 0);
-				break;
+				// surfaces with their own context are drawn by their own thread
+				if(win->egl_context)
+				{
+					continue;
+				}
 
-			case longShader:
-				draw_longShader(&g_window, NULL, 0);
-				break;
+				if(PACING_TIMER == g_framePacing)
+				{
+					win->start_lateness_us = frame_timer_lateness_us(timer);
+				}
+				bind_shared_context(win);
+				draw_scene(win);
+			}
+		}
 
-			case batchDrawArrays:
-				draw_batchDrawArrays(&g_window, NULL, 0);
-				break;
+		// a poll timeout is not a frame
+		if(g_window.frame_id == measured_frame_id)
+		{
+			continue;
+		}
+		measured_frame_id = g_window.frame_id;
 
-			default:
-				printf("Invalid draw case\n");
-				assert(0);
-				break;
+		if(adaptive_run_frame(g_window.frame_time_us))
+		{
+			if(!run_suite || suite_workload_complete(&g_window))
+			{
+				running = 0;
+			}
 		}
 	}
 
 	fprintf(stderr, "stress-weston exiting\n");
 
+	// let the render threads finish their frame
+	running = 0;
+	for(int i=1; i<g_surface_count; i++)
+	{
+		if(g_surfaces[i]->egl_context)
+		{
+			pthread_join(g_render_threads[i], NULL);
+		}
+	}
+	if(PACING_TIMER == g_framePacing)
+	{
+		frame_timer_stop(timer, 0);
+	}
+	param_watch_close();
+	control_socket_close();
+
+	// close the frame metrics file
+	close_metrics_files();
+
+	// the render threads already stopped the readback and the stream
+	// uploads of their surfaces, the others share the main thread's context
+	for(int i=0; i<g_surface_count; i++)
+	{
+		resize_stress_stop(g_surfaces[i]);
+		readback_stop(g_surfaces[i]);
+		stream_upload_stop(g_surfaces[i]);
+	}
+	frame_check_stop();
+	capture_stop();
+
+	if(g_window.headless) {
+		fini_headless_egl(&display, &g_window);
+		return 0;
+	}
+
 	// shutdown all weston resources	
+	for(int i=g_surface_count-1; i>0; i--)
+	{
+		destroy_surface(g_surfaces[i]);
+		if(g_surfaces[i]->egl_context)
+		{
+			eglDestroyContext(display.egl.dpy, g_surfaces[i]->egl_context);
+		}
+		delete g_surfaces[i];
+	}
 	destroy_surface(&g_window);
 	fini_egl(&display);
 
@@ -907,11 +2710,6 @@ int main(int argc, char **argv)
 	wl_display_flush(display.display);
 	wl_display_disconnect(display.display);
 
-	// close the frame metrics file
-	if(g_recordMetrics) {
-		g_metricsfile.close();
-	}
-
 	return 0;
 }
 
@@ -29,6 +29,7 @@
 #include <math.h>
 #include <assert.h>
 #include <signal.h>
+#include <string>
 
 #include <wayland-client.h>
 #include <wayland-egl.h>
@@ -40,6 +41,11 @@
 #define WINDOW_HEIGHT 	1080 
 #define FRAME_TIME_RECORDING_WINDOW_SIZE 500
 
+// how the next frame gets started, params file line 22
+#define PACING_UNTHROTTLED		0	// draw again as soon as the swap returns
+#define PACING_FRAME_CALLBACKS	1	// draw when the compositor's frame callback fires
+#define PACING_TIMER			2	// draw at a fixed rate, see frame-timer.h
+
 
 // structs/forward declaretions
 enum DrawCases {
@@ -49,8 +55,10 @@ enum DrawCases {
 	simpleTexture=3,
 	longShader=4,
 	batchDrawArrays=5,	
-	multiTexture=6,	// future case
-	largeTexture=7, // future case
+	multiTexture=6,
+	largeTexture=7,
+	postProcess=8,
+	streamUpload=9,
 	next_case,
 };
 
@@ -80,8 +88,10 @@ struct display {
 		EGLDisplay dpy;
 		EGLContext ctx;
 		EGLConfig conf;
+		EGLint client_version;	// 3 when the driver has OpenGL ES 3
 	} egl;
 	struct window *window;
+	struct window *keyboard_focus;
 	struct ivi_application *ivi_application;
 	struct wl_list output_list;
 
@@ -184,32 +194,113 @@ struct window {
 	EGLSurface egl_surface;
 	struct wl_callback *callback;
 	int fullscreen, opaque, buffer_size, frame_sync, output;
+	bool headless;		// no compositor, see headless-egl.h
+
+	// window framebuffer, what init_egl() asks the EGL config for
+	int color_format;	// index into g_color_formats
+	int depth_size, stencil_size, samples;
 	
 	// global scene parameters
 	uint32_t benchmark_time, frames;	
 	int offscreen;
+	struct offscreen_state *targets;	// offscreen render targets, see offscreen.h
 	bool no_swapbuffer_call;
 	bool texture_flat_no_rotate;
 	float texture_fetch_radius;
 	float longShader_loop_count;
 	float shortShader_loop_count;
 	float dialsShader_loop_count;
+
+	// scene and pyramid grid, each surface has its own
+	DrawCases draw_case;
+	int x_count, y_count, z_count;
+	int batch_size;
+	GLfloat* pyramid_positions;
+	GLfloat* pyramid_colors_single_draw;
+	GLfloat* pyramid_transforms;
+	struct post_chain *post_chain;	// post-process scene targets, see post-process.h
+	struct texture_set *texture_set;	// multi-texture scene textures, see multi-texture.h
+	struct stream_state *stream;	// streaming upload scene, see stream-upload.h
+
+	// 0 is the first surface, the one the params file watcher, the control
+	// socket and the adaptive run length follow
+	int surface_index;
+
+	// a surface drawn by its own render thread has its own context, in the
+	// share group of the first surface's context
+	EGLContext egl_context;
+
+	// where the surface's frame callbacks get dispatched, NULL for the
+	// default queue
+	struct wl_event_queue *queue;
+
+	// live stats, updated by calculate_fps
+	float fps;
+	uint32_t frame_time_us;
+	uint64_t frame_id;
+	uint64_t prev_frame_timestamp, interval_start;
+	uint32_t start_lateness_us;		// frame timer only, how late the frame started
+	struct frame_metrics *metrics;
+
+	// what changed since the previous frame, see damage.h
+	struct damage_state *damage;
+
+	// presentation, see presenter.h
+	struct present_state *present;
+	uint32_t present_time_us;
+	uint64_t present_time_sum_us;	// since the last fps report
+
+	// resize stress, see resize-stress.h
+	struct resize_stress *resize;
+
+	// frame readback, see readback.h
+	struct readback_state *readback;
 };
 
 // forward declarations
 class textRender;
 
 // globals
-extern DrawCases g_draw_case;
 extern bool g_demo_mode;
-
-// pyramid geometry parameters
-extern int x_count;
-extern int y_count;
-extern int z_count;
-extern int g_batchSize;
 extern textRender g_TextRender;
 extern bool g_recordMetrics;
+extern unsigned int g_fixedTimestep;
+extern unsigned int g_framePacing;
+extern unsigned int g_timerPeriod;
+extern unsigned int g_timerPhase;
+extern unsigned int g_damageTiles;
+extern bool g_partialRedraw;
+extern unsigned int g_presentMode;
+extern unsigned int g_resizeStress;
+extern unsigned int g_resizeInterval;
+extern int g_resizeMinWidth, g_resizeMinHeight;
+extern unsigned int g_offscreenFormat;
+extern unsigned int g_offscreenDepth;
+extern unsigned int g_offscreenSamples;
+extern int g_offscreenWidth, g_offscreenHeight;
+extern unsigned int g_offscreenTargets;
+extern unsigned int g_readbackMode;
+extern unsigned int g_readbackInterval;
+extern unsigned int g_readbackDepth;
+extern unsigned int g_frameCheckMode;
+extern unsigned int g_frameCheckInterval;
+extern unsigned int g_captureMode;
+extern unsigned int g_captureInterval;
+extern unsigned int g_captureQueue;
+extern unsigned int g_postDownsample;
+extern unsigned int g_postBlurPasses;
+extern bool g_postBloom;
+extern bool g_postTonemap;
+extern unsigned int g_textureRawWidth;
+extern unsigned int g_textureUploadRows;
+extern unsigned int g_multiTextureCount;
+extern unsigned int g_multiTextureSize;
+extern unsigned int g_multiTextureFormat;
+extern unsigned int g_multiTextureFalloff;
+extern unsigned int g_streamMode;
+extern unsigned int g_streamWidth;
+extern unsigned int g_streamHeight;
+extern unsigned int g_streamFormat;
 
 
 //digits
@@ -219,20 +310,25 @@ extern GLuint g_digitTextureID;
 extern GLuint g_dialTexID;
 extern GLuint g_needleTexID;
 
-//pyramids
-extern GLfloat* pyramid_positions; 
-extern GLfloat* pyramid_colors_single_draw; 
-extern GLfloat* pyramid_transforms; 
-
 // texture
 extern GLuint g_textureID;
 
 // functions
-void add_shader_loops(DrawCases scene);
-void shrink_shader_loops(DrawCases scene);
-void add_pyramids();
-void remove_pyramids();
+void add_shader_loops(window* win, DrawCases scene);
+void shrink_shader_loops(window* win, DrawCases scene);
+void add_pyramids(window* win);
+void remove_pyramids(window* win);
 void swap_draw_case(window* win, DrawCases drawcase = next_case);
+const char* draw_case_name(DrawCases drawcase);
+bool draw_case_valid(int drawcase);
+void set_metrics_recording(bool enable);
+int set_parameter(window* win, const char* name, const char* value);
+int set_parameters(window* win, const char* settings);
+bool get_parameter(const char* name, std::string& value);
+std::string list_parameters();
+void request_exit();
+void resize_surface(window* win, int width, int height);
+EGLContext create_gles_context(display* display, EGLContext share);
 
 // helpers
 float calculate_fps(window *win, char* test_name, uint32_t& time_now);
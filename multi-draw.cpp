@@ -40,6 +40,8 @@
 
 #include "shaders.h" // quad_verts/etc
 #include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
 
 // glm math library
 #include "glm/vec3.hpp"
@@ -98,12 +100,8 @@ void initialize_multiDrawArrays(window *window)
 void draw_multiDrawArrays (void* data, struct wl_callback* callback, uint32_t time_now)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 
 	static const uint32_t speed_div = 5;
-	struct wl_region *region;
-	EGLint rect[4];
-	EGLint buffer_age = 0;
 
 	// callback and weston setup
 	assert(win->callback == callback);
@@ -112,13 +110,13 @@ void draw_multiDrawArrays (void* data, struct wl_callback* callback, uint32_t ti
 	if (callback)
 		wl_callback_destroy(callback);
 
-	if (display->swap_buffers_with_damage)
-		eglQuerySurface(display->egl.dpy, win->egl_surface,
-				EGL_BUFFER_AGE_EXT, &buffer_age);
-
 	// timer for moving objects and timing frame
 	float fps = calculate_fps(win, "multi_draw", time_now);
 
+	// everything moves, the whole surface is damaged
+	damage_begin(win);
+	damage_add_full(win);
+
 	GLfloat angle = (time_now / speed_div) % 360; // * M_PI / 180.0;
 
 	// start GL rendering loop
@@ -131,12 +129,12 @@ void draw_multiDrawArrays (void* data, struct wl_callback* callback, uint32_t ti
 		(GLfloat *)glm::value_ptr(proj_matrix));	
 
 	// view matrix
-	int maxdim = std::max(x_count, y_count);
-	float xCoord = x_count*1.5f - 1.0f;
-	float yCoord = y_count*1.5f - 1.0f;
+	int maxdim = std::max(win->x_count, win->y_count);
+	float xCoord = win->x_count*1.5f - 1.0f;
+	float yCoord = win->y_count*1.5f - 1.0f;
 
 	glm::vec3 v_eye(xCoord, yCoord, -3.0f * (maxdim/2));
-	glm::vec3 v_center(xCoord, yCoord, z_count*1.5f);
+	glm::vec3 v_center(xCoord, yCoord, win->z_count*1.5f);
 	glm::vec3 v_up(0.0f, 1.0f, 0.0f);
 
 	glm::mat4 view_matrix = glm::lookAt(v_eye, v_center, v_up);
@@ -154,11 +152,11 @@ void draw_multiDrawArrays (void* data, struct wl_callback* callback, uint32_t ti
 	glUniform1f(win->gl_multi.loop_count_short, win->shortShader_loop_count);
 
 	// draw the grid like mad
-	for(int z=(z_count-1); z>=0; z--)
+	for(int z=(win->z_count-1); z>=0; z--)
 	{
-		for(int x=0; x<x_count; x++)
+		for(int x=0; x<win->x_count; x++)
 		{
-			for(int y=0; y<y_count; y++)			
+			for(int y=0; y<win->y_count; y++)			
 			{				
 				glm::mat4 model_matrix(1.f);
 				model_matrix = glm::translate(model_matrix, glm::vec3((float)x*3, (float)y*3, (float)z*3));
@@ -177,31 +175,6 @@ void draw_multiDrawArrays (void* data, struct wl_callback* callback, uint32_t ti
 	// render fps digits
 	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
 
-	// handle flips/weston
-	if (win->opaque || win->fullscreen) {
-		region = wl_compositor_create_region(win->display->compositor);
-		wl_region_add(region, 0, 0,
-			      win->geometry.width,
-			      win->geometry.height);
-		wl_surface_set_opaque_region(win->surface, region);
-		wl_region_destroy(region);
-	} else {
-		wl_surface_set_opaque_region(win->surface, NULL);
-	}
-
-	if(!win->no_swapbuffer_call)
-	{
-		if (display->swap_buffers_with_damage && buffer_age > 0) {
-			rect[0] = win->geometry.width / 4 - 1;
-			rect[1] = win->geometry.height / 4 - 1;
-			rect[2] = win->geometry.width / 2 + 2;
-			rect[3] = win->geometry.height / 2 + 2;
-			display->swap_buffers_with_damage(display->egl.dpy,
-							  win->egl_surface,
-							  rect, 1);
-		} else {
-			eglSwapBuffers(display->egl.dpy, win->egl_surface);
-		}
-	}
-	win->frames++;
+	// swap, or whatever the present mode does instead
+	present_frame(win);
 }
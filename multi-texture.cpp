@@ -0,0 +1,366 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "multi-texture.h"
+
+#include "shaders.h" 	// quad_verts/etc
+#include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
+
+// the attribute the program reads the quad from
+#define MULTI_POS_ATTRIBUTE	0
+
+struct texture_set {
+	GLuint program;
+	GLint offset_uniform, weight_uniform;
+	int program_count;		// textures the program samples
+
+	// made for these settings
+	int count, size;
+	unsigned int format;
+	GLuint textures[MAX_MULTI_TEXTURES];
+};
+
+//------------------------------------------------------------------------------
+const char* multi_texture_format_name(unsigned int format)
+{
+	switch(format)
+	{
+		case multiTextureRGBA8:			return "RGBA8";
+		case multiTextureRGB565:		return "RGB565";
+		case multiTextureRGBA4444:		return "RGBA4444";
+		case multiTextureLuminance8:	return "L8";
+		default:						return "unknown";
+	}
+}
+
+//------------------------------------------------------------------------------
+static int bytes_per_texel(unsigned int format)
+{
+	switch(format)
+	{
+		case multiTextureRGB565:
+		case multiTextureRGBA4444:
+			return 2;
+		case multiTextureLuminance8:
+			return 1;
+		default:
+			return 4;
+	}
+}
+
+// the textures drawn, at most one per texture unit the fragment shader has
+//------------------------------------------------------------------------------
+static int multi_texture_count()
+{
+	static GLint units = 0;
+	if(0 == units)
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+		units = std::min(std::max(units, 1), MAX_MULTI_TEXTURES);
+	}
+	return std::min((int)g_multiTextureCount, (int)units);
+}
+
+// the texture size, at most what the GPU takes
+//------------------------------------------------------------------------------
+static int multi_texture_size()
+{
+	static GLint max_size = 0;
+	if(0 == max_size)
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	}
+	return std::min((int)g_multiTextureSize, (int)max_size);
+}
+
+//------------------------------------------------------------------------------
+double multi_texture_working_set()
+{
+	double size = multi_texture_size();
+	return multi_texture_count() * size * size * bytes_per_texel(g_multiTextureFormat);
+}
+
+// the fragment shader is generated for the number of textures, GLES2 can
+// only index sampler arrays with constants
+//------------------------------------------------------------------------------
+static GLuint link_program(window* win, int count)
+{
+	char line[160];
+	std::string source = "precision mediump float;\n"
+		"varying vec2 v_texcoord1;\n";
+	snprintf(line, sizeof(line), "uniform vec2 offset[%d];\nuniform float weight[%d];\n", count, count);
+	source += line;
+	for(int i=0; i<count; i++)
+	{
+		snprintf(line, sizeof(line), "uniform sampler2D texSampler%d;\n", i);
+		source += line;
+	}
+	source += "void main() {\n"
+		"  vec4 color = vec4(0.0);\n";
+	for(int i=0; i<count; i++)
+	{
+		snprintf(line, sizeof(line), "  color += weight[%d] * texture2D(texSampler%d, v_texcoord1 + offset[%d]);\n", i, i, i);
+		source += line;
+	}
+	source += "  gl_FragColor = color;\n"
+		"}\n";
+
+	GLuint vert = create_shader(win, vert_shader_post, GL_VERTEX_SHADER);
+	GLuint frag = create_shader(win, source.c_str(), GL_FRAGMENT_SHADER);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, frag);
+	glAttachShader(program, vert);
+	glBindAttribLocation(program, MULTI_POS_ATTRIBUTE, "pos");
+	glLinkProgram(program);
+
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status) {
+		char log[1000];
+		GLsizei len;
+		glGetProgramInfoLog(program, 1000, &len, log);
+		fprintf(stderr, "Error: linking:\n%*s\n", len, log);
+		exit(1);
+	}
+	glDeleteShader(vert);
+	glDeleteShader(frag);
+
+	// texture i is on unit i
+	glUseProgram(program);
+	for(int i=0; i<count; i++)
+	{
+		snprintf(line, sizeof(line), "texSampler%d", i);
+		glUniform1i(glGetUniformLocation(program, line), i);
+	}
+	return program;
+}
+
+// noise in a tint of its own, so every texture is different and none of
+// them compresses or caches well
+//------------------------------------------------------------------------------
+static void fill_texture(GLubyte* pixels, int size, unsigned int format, int index)
+{
+	int tint_r = 128 + ((index * 37) & 127);
+	int tint_g = 128 + ((index * 59) & 127);
+	int tint_b = 128 + ((index * 83) & 127);
+
+	GLushort* packed = (GLushort*)pixels;
+	for(int y=0; y<size; y++)
+	{
+		for(int x=0; x<size; x++)
+		{
+			uint32_t h = (x * 0x8da6b343u) ^ (y * 0xd8163841u) ^ (index * 0xcb1ab31fu);
+			h ^= h >> 13;
+			h *= 0x5bd1e995u;
+			h ^= h >> 15;
+			int noise = h & 0xff;
+			int r = noise * tint_r / 255, g = noise * tint_g / 255, b = noise * tint_b / 255;
+
+			switch(format)
+			{
+				case multiTextureRGB565:
+					*packed++ = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+					break;
+				case multiTextureRGBA4444:
+					*packed++ = ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | 0xf;
+					break;
+				case multiTextureLuminance8:
+					*pixels++ = noise;
+					break;
+				default:
+					pixels[0] = r;
+					pixels[1] = g;
+					pixels[2] = b;
+					pixels[3] = 255;
+					pixels += 4;
+					break;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+static void upload_texture(GLuint texture, const GLubyte* pixels, int size, unsigned int format)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// the sizes are powers of two, so the textures can repeat as they pan.
+	// No mipmaps, the minified fetches are spread over the whole texture
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+	switch(format)
+	{
+		case multiTextureRGB565:
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels);
+			break;
+		case multiTextureRGBA4444:
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, pixels);
+			break;
+		case multiTextureLuminance8:
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, size, size, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
+			break;
+		default:
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+			break;
+	}
+}
+
+// (re)make the textures and the program when the settings changed
+//------------------------------------------------------------------------------
+static void update_textures(texture_set* set, window* win, int count)
+{
+	int size = multi_texture_size();
+	unsigned int format = g_multiTextureFormat;
+	if((set->count == count) && (set->size == size) && (set->format == format))
+	{
+		return;
+	}
+
+	if(set->count)
+	{
+		glDeleteTextures(set->count, set->textures);
+	}
+	glGenTextures(count, set->textures);
+	GLubyte* pixels = new GLubyte[(size_t)size * size * bytes_per_texel(format)];
+	for(int i=0; i<count; i++)
+	{
+		fill_texture(pixels, size, format, i);
+		upload_texture(set->textures[i], pixels, size, format);
+	}
+	delete[] pixels;
+
+	if(set->program_count != count)
+	{
+		if(set->program)
+		{
+			glDeleteProgram(set->program);
+		}
+		set->program = link_program(win, count);
+		set->offset_uniform = glGetUniformLocation(set->program, "offset");
+		set->weight_uniform = glGetUniformLocation(set->program, "weight");
+		set->program_count = count;
+	}
+
+	set->count = count;
+	set->size = size;
+	set->format = format;
+}
+
+// setup code for the multi-texture scene, the textures are made the first
+// time it's drawn
+//------------------------------------------------------------------------------
+void initialize_multiTexture(window *window)
+{
+	texture_set* set = new texture_set;
+	memset(set, 0, sizeof(*set));
+	window->texture_set = set;
+}
+
+// Test scene: fullscreen quad sampling many textures per fragment
+//------------------------------------------------------------------------------
+void draw_multiTexture(void *data, struct wl_callback *callback, uint32_t time_now)
+{
+	struct window *win = (window*)data;
+	texture_set* set = win->texture_set;
+
+	// callback and weston setup
+	assert(win->callback == callback);
+	win->callback = NULL;
+
+	if (callback)
+		wl_callback_destroy(callback);
+
+	// timer for moving objects and timing frame
+	float fps = calculate_fps(win, "multi_texture", time_now);
+
+	// the textures pan across a fullscreen quad, every pixel changes
+	damage_begin(win);
+	damage_add_full(win);
+
+	int count = multi_texture_count();
+	update_textures(set, win, count);
+
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	// every texture pans at its own speed, the weights fall off from the
+	// first texture and add up to 1
+	GLfloat offsets[2 * MAX_MULTI_TEXTURES];
+	GLfloat weights[MAX_MULTI_TEXTURES];
+	float weight = 1.0f, total = 0.0f;
+	for(int i=0; i<count; i++)
+	{
+		offsets[2*i + 0] = fmodf(time_now * 0.00003f * (i + 1), 1.0f);
+		offsets[2*i + 1] = fmodf(time_now * 0.00002f * (count - i), 1.0f);
+		weights[i] = weight;
+		total += weight;
+		weight *= g_multiTextureFalloff / 100.0f;
+	}
+	for(int i=0; i<count; i++)
+	{
+		weights[i] /= total;
+	}
+
+	glUseProgram(set->program);
+	glUniform2fv(set->offset_uniform, count, offsets);
+	glUniform1fv(set->weight_uniform, count, weights);
+	for(int i=0; i<count; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, set->textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	glVertexAttribPointer(MULTI_POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
+	glEnableVertexAttribArray(MULTI_POS_ATTRIBUTE);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDisableVertexAttribArray(MULTI_POS_ATTRIBUTE);
+
+	// draw fps
+	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
+
+	// swap, or whatever the present mode does instead
+	present_frame(win);
+}
@@ -0,0 +1,57 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __MULTI_TEXTURE_H__
+#define __MULTI_TEXTURE_H__
+
+#include <stdint.h>
+
+#include "main.h"
+
+// Multi-texture scene
+// A fullscreen quad that samples g_multiTextureCount textures (params file
+// line 56), each on its own texture unit, in every fragment and blends them
+// with weights that fall off by g_multiTextureFalloff percent (59) from one
+// texture to the next. The textures are g_multiTextureSize (57) square in
+// the format g_multiTextureFormat (58) picks, without mipmaps, and pan at
+// different speeds, so no two of them are read at the same texels. With the
+// defaults the working set is 32 MB, far more than the GPU caches hold, so
+// the scene shows texture cache thrashing and the sampler throughput limit.
+
+#define MAX_MULTI_TEXTURES	32
+
+enum multi_texture_format {
+	multiTextureRGBA8 = 0,
+	multiTextureRGB565,
+	multiTextureRGBA4444,
+	multiTextureLuminance8,
+	multiTextureFormatCount,
+};
+
+void initialize_multiTexture(window *window);
+void draw_multiTexture(void *data, struct wl_callback *callback, uint32_t time);
+
+const char* multi_texture_format_name(unsigned int format);
+
+// bytes the textures take with the current settings
+double multi_texture_working_set();
+
+#endif // __MULTI_TEXTURE_H__
@@ -0,0 +1,371 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+
+#include "main.h"
+#include "offscreen.h"
+
+struct offscreen_format {
+	const char* name;
+	GLenum internal_format;		// sized, for OpenGL ES 3
+	GLenum format, type;		// what OpenGL ES 2 takes
+	bool es3;					// only renderable with OpenGL ES 3
+	const char* extension;		// needed as well, NULL for none
+};
+
+static const offscreen_format g_offscreen_formats[offscreenFormatCount] = {
+	{ "RGB565",		GL_RGB565,		GL_RGB,		GL_UNSIGNED_SHORT_5_6_5,			false,	NULL },
+	{ "RGBA8",		GL_RGBA8,		GL_RGBA,	GL_UNSIGNED_BYTE,					false,	NULL },
+	{ "RGB10A2",	GL_RGB10_A2,	GL_RGBA,	GL_UNSIGNED_INT_2_10_10_10_REV,		true,	NULL },
+	{ "RGBA16F",	GL_RGBA16F,		GL_RGBA,	GL_HALF_FLOAT,						true,	"GL_EXT_color_buffer_half_float" },
+};
+
+struct offscreen_target {
+	GLuint fbo;				// what the scenes draw into
+	GLuint texture;			// the color buffer, or where the samples are resolved to
+	GLuint samples_color;	// multisampled color renderbuffer, 0 without MSAA
+	GLuint resolve_fbo;		// multisampled only, the texture's framebuffer
+	GLuint depth;			// 0 without depth
+};
+
+struct offscreen_state {
+	offscreen_target targets[MAX_OFFSCREEN_TARGETS];
+	int count;
+	int current;			// the target being drawn
+
+	int width, height;
+	bool follow_window;		// no size in the params file, the window's size is used
+	bool es3;
+	unsigned int format;	// OffscreenFormats
+	GLenum depth_format;	// 0 without depth
+	int samples;
+};
+
+//------------------------------------------------------------------------------
+const char* offscreen_format_name(unsigned int format)
+{
+	if(format >= offscreenFormatCount)
+	{
+		return "unknown";
+	}
+	return g_offscreen_formats[format].name;
+}
+
+// the whole name has to match, not just the start of a longer one
+//------------------------------------------------------------------------------
+static bool has_gl_extension(const char* name)
+{
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	size_t length = strlen(name);
+	for(const char* p = extensions; p && (p = strstr(p, name)); p += length)
+	{
+		if(((p == extensions) || (p[-1] == ' ')) && ((p[length] == ' ') || (p[length] == '\0')))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// the context's major version, contexts are asked for OpenGL ES 3 first
+//------------------------------------------------------------------------------
+static int gles_major_version()
+{
+	const char* version = (const char*)glGetString(GL_VERSION);
+	int major = 2;
+	if(version && (1 == sscanf(version, "OpenGL ES %d", &major)))
+	{
+		return major;
+	}
+	return 2;
+}
+
+//------------------------------------------------------------------------------
+static bool format_supported(unsigned int format, bool es3)
+{
+	const offscreen_format& f = g_offscreen_formats[format];
+	if(f.es3 && !es3)
+	{
+		return false;
+	}
+	if(f.extension && !has_gl_extension(f.extension))
+	{
+		// EXT_color_buffer_float covers the half float formats too
+		return (offscreenRGBA16F == format) && has_gl_extension("GL_EXT_color_buffer_float");
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+static void check_framebuffer(int index, const char* what)
+{
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if(GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		printf("Offscreen target %d: the %s framebuffer is incomplete, 0x%x\n", index, what, status);
+		exit(1);
+	}
+}
+
+// (re)allocate the storage of a target at the current size
+//------------------------------------------------------------------------------
+static void allocate_target(const offscreen_state* state, const offscreen_target& target)
+{
+	const offscreen_format& format = g_offscreen_formats[state->format];
+
+	GLint texture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glBindTexture(GL_TEXTURE_2D, target.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, state->es3 ? format.internal_format : format.format,
+		state->width, state->height, 0, format.format, format.type, NULL);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	if(target.samples_color)
+	{
+		glBindRenderbuffer(GL_RENDERBUFFER, target.samples_color);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, state->samples, format.internal_format, state->width, state->height);
+	}
+	if(target.depth)
+	{
+		glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+		if(state->samples)
+		{
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, state->samples, state->depth_format, state->width, state->height);
+		}
+		else
+		{
+			glRenderbufferStorage(GL_RENDERBUFFER, state->depth_format, state->width, state->height);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+static void create_target(const offscreen_state* state, offscreen_target& target, int index)
+{
+	glGenFramebuffers(1, &target.fbo);
+	glGenTextures(1, &target.texture);
+	if(state->samples)
+	{
+		glGenRenderbuffers(1, &target.samples_color);
+		glGenFramebuffers(1, &target.resolve_fbo);
+	}
+	if(state->depth_format)
+	{
+		glGenRenderbuffers(1, &target.depth);
+	}
+
+	GLint texture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	glBindTexture(GL_TEXTURE_2D, target.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	allocate_target(state, target);
+
+	if(state->samples)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, target.resolve_fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+		check_framebuffer(index, "resolve");
+
+		glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.samples_color);
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+	}
+	if(target.depth)
+	{
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+	}
+	check_framebuffer(index, "render");
+}
+
+// create the targets and bind the first one, exits if the driver can't
+// render to them
+//------------------------------------------------------------------------------
+void offscreen_init(window* win)
+{
+	offscreen_state* state = new offscreen_state;
+	memset(state, 0, sizeof(*state));
+	state->es3 = (gles_major_version() >= 3);
+
+	state->format = g_offscreenFormat;
+	if(state->format >= offscreenFormatCount)
+	{
+		printf("Unknown offscreen format %u, using %s\n", state->format, offscreen_format_name(offscreenRGB565));
+		state->format = offscreenRGB565;
+	}
+	if(!format_supported(state->format, state->es3))
+	{
+		printf("The driver can't render to %s, using %s\n", offscreen_format_name(state->format), offscreen_format_name(offscreenRGB565));
+		state->format = offscreenRGB565;
+	}
+
+	// GL_DEPTH_COMPONENT24 has the same value as OES_depth24's enum
+	if(g_offscreenDepth > 16)
+	{
+		state->depth_format = GL_DEPTH_COMPONENT24;
+		if(!state->es3 && !has_gl_extension("GL_OES_depth24"))
+		{
+			printf("No 24 bit offscreen depth buffer, using 16 bits\n");
+			state->depth_format = GL_DEPTH_COMPONENT16;
+		}
+	}
+	else if(g_offscreenDepth)
+	{
+		state->depth_format = GL_DEPTH_COMPONENT16;
+	}
+
+	if(g_offscreenSamples)
+	{
+		GLint max_samples = 0;
+		if(state->es3)
+		{
+			glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+		}
+		state->samples = std::min((int)g_offscreenSamples, (int)max_samples);
+		if(state->samples != (int)g_offscreenSamples)
+		{
+			printf("%u offscreen samples asked for, the driver has at most %d\n", g_offscreenSamples, max_samples);
+		}
+	}
+
+	state->follow_window = (0 == g_offscreenWidth) || (0 == g_offscreenHeight);
+	state->width = state->follow_window ? win->geometry.width : g_offscreenWidth;
+	state->height = state->follow_window ? win->geometry.height : g_offscreenHeight;
+
+	state->count = std::min(std::max((int)g_offscreenTargets, 1), MAX_OFFSCREEN_TARGETS);
+	for(int i=0; i<state->count; i++)
+	{
+		create_target(state, state->targets[i], i);
+	}
+
+	state->current = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, state->targets[0].fbo);
+	win->targets = state;
+
+	printf("Offscreen: %d %s target%s of (%d,%d)%s, depth %d, samples %d, OpenGL ES %d\n",
+		state->count,
+		offscreen_format_name(state->format),
+		(state->count > 1) ? "s" : "",
+		state->width, state->height,
+		state->follow_window ? " following the window" : "",
+		state->depth_format ? ((GL_DEPTH_COMPONENT16 == state->depth_format) ? 16 : 24) : 0,
+		state->samples,
+		state->es3 ? 3 : 2);
+}
+
+// the window was resized, targets that follow its size are reallocated
+//------------------------------------------------------------------------------
+void offscreen_resize(window* win)
+{
+	offscreen_state* state = win->targets;
+	if(!state || !state->follow_window)
+	{
+		return;
+	}
+	if((state->width == win->geometry.width) && (state->height == win->geometry.height))
+	{
+		return;
+	}
+
+	state->width = win->geometry.width;
+	state->height = win->geometry.height;
+	for(int i=0; i<state->count; i++)
+	{
+		allocate_target(state, state->targets[i]);
+	}
+}
+
+// the size the scenes draw at, the offscreen target's or the window's
+//------------------------------------------------------------------------------
+void render_target_size(const window* win, int& width, int& height)
+{
+	if(win->targets)
+	{
+		width = win->targets->width;
+		height = win->targets->height;
+	}
+	else
+	{
+		width = win->geometry.width;
+		height = win->geometry.height;
+	}
+}
+
+// resolve a multisampled target and bind the framebuffer that holds the
+// finished frame, so it can be read back
+//------------------------------------------------------------------------------
+void offscreen_resolve(window* win)
+{
+	offscreen_state* state = win->targets;
+	if(!state || !state->samples)
+	{
+		return;
+	}
+
+	const offscreen_target& target = state->targets[state->current];
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.resolve_fbo);
+	glBlitFramebuffer(0, 0, state->width, state->height,
+					  0, 0, state->width, state->height,
+					  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.resolve_fbo);
+}
+
+// how the finished frame is read back, RGBA bytes or, for half float
+// targets, RGBA floats
+//------------------------------------------------------------------------------
+void offscreen_read_format(const window* win, GLenum& format, GLenum& type, int& bytes_per_pixel)
+{
+	format = GL_RGBA;
+	type = GL_UNSIGNED_BYTE;
+	bytes_per_pixel = 4;
+	if(win->targets && (offscreenRGBA16F == win->targets->format))
+	{
+		type = GL_FLOAT;
+		bytes_per_pixel = 16;
+	}
+}
+
+// the frame is presented, bind the next target
+//------------------------------------------------------------------------------
+void offscreen_next_target(window* win)
+{
+	offscreen_state* state = win->targets;
+	if(!state)
+	{
+		return;
+	}
+
+	state->current = (state->current + 1) % state->count;
+	glBindFramebuffer(GL_FRAMEBUFFER, state->targets[state->current].fbo);
+}
@@ -0,0 +1,68 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __OFFSCREEN_H__
+#define __OFFSCREEN_H__
+
+// Offscreen render targets
+// With offscreen (params file line 5) the scenes draw into framebuffer
+// objects instead of the window. The color format (line 36), depth bits
+// (37), MSAA samples (38), size (39, 40, 0 follows the window) and number of
+// targets (41) are configurable. The targets are drawn in turn, one per
+// frame, so a run moves as much memory as a render-to-texture pipeline does
+// instead of reusing one buffer. The color buffers are textures; a
+// multisampled target draws into a renderbuffer that is resolved into its
+// texture when the frame is presented.
+
+enum OffscreenFormats {
+	offscreenRGB565 = 0,
+	offscreenRGBA8,
+	offscreenRGB10A2,	// OpenGL ES 3
+	offscreenRGBA16F,	// OpenGL ES 3 and EXT_color_buffer_half_float
+	offscreenFormatCount,
+};
+
+#define MAX_OFFSCREEN_TARGETS	16
+
+// create the targets and bind the first one, exits if the driver can't
+// render to them
+void offscreen_init(window* win);
+
+// the window was resized, targets that follow its size are reallocated
+void offscreen_resize(window* win);
+
+// the size the scenes draw at, the offscreen target's or the window's
+void render_target_size(const window* win, int& width, int& height);
+
+// resolve a multisampled target and bind the framebuffer that holds the
+// finished frame, so it can be read back
+void offscreen_resolve(window* win);
+
+// how the finished frame is read back, RGBA bytes or, for half float
+// targets, RGBA floats
+void offscreen_read_format(const window* win, GLenum& format, GLenum& type, int& bytes_per_pixel);
+
+// the frame is presented, bind the next target
+void offscreen_next_target(window* win);
+
+const char* offscreen_format_name(unsigned int format);
+
+#endif // __OFFSCREEN_H__
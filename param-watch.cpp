@@ -0,0 +1,118 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <string>
+
+#include "param-watch.h"
+
+static int g_inotify_fd = -1;
+static int g_watch_descriptor = -1;
+static std::string g_watched_name;
+
+// Editors usually write a new file and rename it over the old one, which 
+// drops an inotify watch placed on the file itself. Watch the directory 
+// instead and filter the events down to the params file name.
+//------------------------------------------------------------------------------
+bool param_watch_init(const char* filename)
+{
+	std::string path(filename);
+	std::string dir = ".";
+
+	size_t slash = path.find_last_of('/');
+	if(std::string::npos != slash)
+	{
+		dir = (0 == slash) ? "/" : path.substr(0, slash);
+		g_watched_name = path.substr(slash + 1);
+	}
+	else
+	{
+		g_watched_name = path;
+	}
+
+	g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(g_inotify_fd < 0)
+	{
+		printf("Unable to watch %s for changes: %s\n", filename, strerror(errno));
+		return false;
+	}
+
+	g_watch_descriptor = inotify_add_watch(g_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if(g_watch_descriptor < 0)
+	{
+		printf("Unable to watch %s for changes: %s\n", filename, strerror(errno));
+		param_watch_close();
+		return false;
+	}
+
+	printf("Watching %s for parameter changes\n", filename);
+	return true;
+}
+
+// drain all pending events, a single save can produce several of them
+//------------------------------------------------------------------------------
+bool param_watch_changed()
+{
+	if(g_inotify_fd < 0)
+	{
+		return false;
+	}
+
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	bool changed = false;
+
+	for(;;)
+	{
+		ssize_t len = read(g_inotify_fd, buffer, sizeof(buffer));
+		if(len <= 0)
+		{
+			break;
+		}
+
+		for(char* ptr = buffer; ptr < buffer + len; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*) ptr;
+			if(event->len && g_watched_name == event->name)
+			{
+				changed = true;
+			}
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+void param_watch_close()
+{
+	if(g_inotify_fd >= 0)
+	{
+		close(g_inotify_fd);
+	}
+	g_inotify_fd = -1;
+	g_watch_descriptor = -1;
+}
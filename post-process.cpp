@@ -0,0 +1,331 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <algorithm>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "post-process.h"
+
+#include "shaders.h" 	// quad_verts/etc
+#include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
+
+// glm math library
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+// the bright pass keeps the pixels brighter than this
+#define BLOOM_THRESHOLD	0.6f
+
+// the attribute every pass program reads the quad from
+#define POST_POS_ATTRIBUTE	0
+
+struct post_target {
+	GLuint texture, fbo;
+	int width, height;
+};
+
+struct post_chain {
+	GLuint downsample_program;
+	GLint downsample_texel, downsample_threshold;
+	GLuint blur_program;
+	GLint blur_step;
+	GLuint combine_program;
+	GLint combine_bloom, combine_tonemap;
+
+	// sized for the render target and the number of downsamples
+	int width, height, downsamples;
+	post_target scene;
+	post_target levels[MAX_POST_DOWNSAMPLES];
+	post_target blur[2];
+};
+
+//------------------------------------------------------------------------------
+static GLuint link_pass_program(window* win, const char* frag_source)
+{
+	GLuint vert = create_shader(win, vert_shader_post, GL_VERTEX_SHADER);
+	GLuint frag = create_shader(win, frag_source, GL_FRAGMENT_SHADER);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, frag);
+	glAttachShader(program, vert);
+	glBindAttribLocation(program, POST_POS_ATTRIBUTE, "pos");
+	glLinkProgram(program);
+
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status) {
+		char log[1000];
+		GLsizei len;
+		glGetProgramInfoLog(program, 1000, &len, log);
+		fprintf(stderr, "Error: linking:\n%*s\n", len, log);
+		exit(1);
+	}
+
+	// the source texture is always unit 0, the combine's blurred image unit 1
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "texSampler1"), 0);
+	glUniform1i(glGetUniformLocation(program, "texSampler2"), 1);
+	return program;
+}
+
+//------------------------------------------------------------------------------
+static void create_target(post_target& target, int width, int height)
+{
+	target.width = std::max(width, 1);
+	target.height = std::max(height, 1);
+
+	glGenTextures(1, &target.texture);
+	glBindTexture(GL_TEXTURE_2D, target.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target.width, target.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &target.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+	if(GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER))
+	{
+		printf("Post-process: can't render to a (%d,%d) RGBA target\n", target.width, target.height);
+		exit(1);
+	}
+}
+
+//------------------------------------------------------------------------------
+static void destroy_target(post_target& target)
+{
+	if(target.fbo)
+	{
+		glDeleteFramebuffers(1, &target.fbo);
+		glDeleteTextures(1, &target.texture);
+	}
+	memset(&target, 0, sizeof(target));
+}
+
+// (re)allocate the targets when the frame size or the number of
+// downsamples changed, with the frame's framebuffer bound again after
+//------------------------------------------------------------------------------
+static void update_targets(post_chain* chain, int width, int height, int downsamples, GLint frame_fbo)
+{
+	if((chain->width == width) && (chain->height == height) && (chain->downsamples == downsamples))
+	{
+		return;
+	}
+
+	destroy_target(chain->scene);
+	for(int i=0; i<MAX_POST_DOWNSAMPLES; i++)
+	{
+		destroy_target(chain->levels[i]);
+	}
+	destroy_target(chain->blur[0]);
+	destroy_target(chain->blur[1]);
+
+	create_target(chain->scene, width, height);
+	for(int i=0; i<downsamples; i++)
+	{
+		create_target(chain->levels[i], width >> (i + 1), height >> (i + 1));
+	}
+	const post_target& smallest = downsamples ? chain->levels[downsamples - 1] : chain->scene;
+	create_target(chain->blur[0], smallest.width, smallest.height);
+	create_target(chain->blur[1], smallest.width, smallest.height);
+
+	chain->width = width;
+	chain->height = height;
+	chain->downsamples = downsamples;
+	glBindFramebuffer(GL_FRAMEBUFFER, frame_fbo);
+}
+
+// one fullscreen pass from 'source' into 'target'
+//------------------------------------------------------------------------------
+static void draw_pass(const post_target& source, const post_target& target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+	glViewport(0, 0, target.width, target.height);
+	glBindTexture(GL_TEXTURE_2D, source.texture);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+// fullscreen passes drawn per frame with the current settings
+//------------------------------------------------------------------------------
+int post_process_pass_count()
+{
+	// the scene, the downsamples (or a full size bright pass for the bloom),
+	// two per blur and the combine
+	int downsamples = std::min((int)g_postDownsample, MAX_POST_DOWNSAMPLES);
+	int bright_pass = ((0 == downsamples) && g_postBloom) ? 1 : 0;
+	return 1 + downsamples + bright_pass + 2 * g_postBlurPasses + 1;
+}
+
+// setup code for the post-process chain
+//------------------------------------------------------------------------------
+void initialize_postProcess(window *window)
+{
+	post_chain* chain = new post_chain;
+	memset(chain, 0, sizeof(*chain));
+
+	chain->downsample_program = link_pass_program(window, frag_shader_post_downsample);
+	chain->downsample_texel = glGetUniformLocation(chain->downsample_program, "texel");
+	chain->downsample_threshold = glGetUniformLocation(chain->downsample_program, "threshold");
+
+	chain->blur_program = link_pass_program(window, frag_shader_post_blur);
+	chain->blur_step = glGetUniformLocation(chain->blur_program, "blur_step");
+
+	chain->combine_program = link_pass_program(window, frag_shader_post_combine);
+	chain->combine_bloom = glGetUniformLocation(chain->combine_program, "bloom");
+	chain->combine_tonemap = glGetUniformLocation(chain->combine_program, "tonemap");
+
+	// the scene pass draws the texture scene's texture with its shader,
+	// loaded by initialize_simpleTexture()
+	window->post_chain = chain;
+}
+
+// Test scene: textured quad, then a chain of fullscreen passes
+//------------------------------------------------------------------------------
+void draw_postProcess(void *data, struct wl_callback *callback, uint32_t time_now)
+{
+	struct window *win = (window*)data;
+	post_chain* chain = win->post_chain;
+	static const uint32_t speed_div = 5;
+
+	// callback and weston setup
+	assert(win->callback == callback);
+	win->callback = NULL;
+
+	if (callback)
+		wl_callback_destroy(callback);
+
+	// timer for moving objects and timing frame
+	float fps = calculate_fps(win, "post_process", time_now);
+
+	// the blur and bloom of the turning quad spread over the whole frame
+	damage_begin(win);
+	damage_add_full(win);
+
+	// the window or the offscreen target the frame ends up in
+	GLint frame_fbo = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &frame_fbo);
+
+	int width, height;
+	render_target_size(win, width, height);
+	int downsamples = std::min((int)g_postDownsample, MAX_POST_DOWNSAMPLES);
+	update_targets(chain, width, height, downsamples, frame_fbo);
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glActiveTexture(GL_TEXTURE0);
+
+	// the scene: the texture scene's quad, turning slowly
+	glBindFramebuffer(GL_FRAMEBUFFER, chain->scene.fbo);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glUseProgram(win->gl_tex.program);
+	glBindTexture(GL_TEXTURE_2D, g_textureID);
+
+	GLfloat angle = (time_now / (speed_div * 2)) % 360;
+	glm::mat4 identity_matrix(1.f);
+	glm::mat4 ortho_matrix = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+	glm::mat4 view_matrix = glm::lookAt(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 model_matrix = glm::rotate(identity_matrix, angle*(3.14159265f/180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glUniformMatrix4fv(win->gl_tex.projection_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(ortho_matrix));
+	glUniformMatrix4fv(win->gl_tex.view_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(view_matrix));
+	glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(model_matrix));
+	glUniform1f(win->gl_tex.shader_loop_count, 0);
+
+	glVertexAttribPointer(win->gl_tex.pos, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
+	glVertexAttribPointer(win->gl_tex.tex1, 2, GL_FLOAT, GL_FALSE, 0, quad_texcoords);
+	glEnableVertexAttribArray(win->gl_tex.pos);
+	glEnableVertexAttribArray(win->gl_tex.tex1);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDisableVertexAttribArray(win->gl_tex.pos);
+	glDisableVertexAttribArray(win->gl_tex.tex1);
+
+	// the passes only read the quad's positions
+	glVertexAttribPointer(POST_POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
+	glEnableVertexAttribArray(POST_POS_ATTRIBUTE);
+
+	// downsamples, the first one is the bloom's bright pass
+	const post_target* source = &chain->scene;
+	glUseProgram(chain->downsample_program);
+	for(int i=0; i<downsamples; i++)
+	{
+		glUniform2f(chain->downsample_texel, 1.0f / source->width, 1.0f / source->height);
+		glUniform1f(chain->downsample_threshold, ((0 == i) && g_postBloom) ? BLOOM_THRESHOLD : 0.0f);
+		draw_pass(*source, chain->levels[i]);
+		source = &chain->levels[i];
+	}
+
+	// without downsamples the bloom's bright pass runs at full size, into the
+	// blur target the first blur doesn't draw to. The half texel offsets
+	// average 2x2 pixels instead of halving the image
+	if((0 == downsamples) && g_postBloom)
+	{
+		glUniform2f(chain->downsample_texel, 0.5f / source->width, 0.5f / source->height);
+		glUniform1f(chain->downsample_threshold, BLOOM_THRESHOLD);
+		draw_pass(*source, chain->blur[1]);
+		source = &chain->blur[1];
+	}
+
+	// separable blurs, ping-ponging between the two blur targets
+	glUseProgram(chain->blur_program);
+	for(unsigned int i=0; i<g_postBlurPasses; i++)
+	{
+		glUniform2f(chain->blur_step, 1.0f / source->width, 0.0f);
+		draw_pass(*source, chain->blur[0]);
+		glUniform2f(chain->blur_step, 0.0f, 1.0f / chain->blur[0].height);
+		draw_pass(chain->blur[0], chain->blur[1]);
+		source = &chain->blur[1];
+	}
+
+	// combine into the frame
+	glBindFramebuffer(GL_FRAMEBUFFER, frame_fbo);
+	glViewport(0, 0, width, height);
+	glUseProgram(chain->combine_program);
+	glUniform1f(chain->combine_bloom, g_postBloom ? 1.0f : 0.0f);
+	glUniform1f(chain->combine_tonemap, g_postTonemap ? 1.0f : 0.0f);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, source->texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, chain->scene.texture);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDisableVertexAttribArray(POST_POS_ATTRIBUTE);
+
+	// draw fps
+	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
+
+	// swap, or whatever the present mode does instead
+	present_frame(win);
+}
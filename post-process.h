@@ -0,0 +1,48 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __POST_PROCESS_H__
+#define __POST_PROCESS_H__
+
+#include <stdint.h>
+
+#include "main.h"
+
+// Post-process chain scene
+// Draws the texture scene's quad into a render target and runs a chain of
+// fullscreen passes over it, ping-ponging between render targets like a
+// compositor's blur or a game's bloom does: g_postDownsample (params file
+// line 50) half size downsamples, g_postBlurPasses (51) separable Gaussian
+// blurs (a horizontal and a vertical pass each) at the downsampled size,
+// then one pass into the frame that adds the blurred image to the scene
+// (bloom, 52) or shows it alone, optionally tone mapped (53). With the bloom
+// the first downsample is also the bright pass, or a full size pass of its
+// own without downsamples.
+
+#define MAX_POST_DOWNSAMPLES	5
+
+void initialize_postProcess(window *window);
+void draw_postProcess(void *data, struct wl_callback *callback, uint32_t time);
+
+// fullscreen passes drawn per frame with the current settings
+int post_process_pass_count();
+
+#endif // __POST_PROCESS_H__
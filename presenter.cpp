@@ -0,0 +1,207 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+
+#include "main.h"
+#include "presenter.h"
+#include "damage.h"
+#include "offscreen.h"
+#include "readback.h"
+
+struct present_state {
+	// what the opaque region was last set to, it is kept by the surface
+	// and only sent again when the size or fullscreen state changes
+	bool region_set;
+	bool region_opaque;
+	int region_width, region_height;
+
+	// readback destination
+	GLubyte* pixels;
+	size_t pixels_size;
+};
+
+static const char* g_present_mode_names[presentModeCount] = {
+	"swap_damage",
+	"swap",
+	"flush",
+	"finish",
+	"readback",
+};
+
+//------------------------------------------------------------------------------
+const char* present_mode_name(unsigned int mode)
+{
+	if(mode >= presentModeCount)
+	{
+		return "unknown";
+	}
+	return g_present_mode_names[mode];
+}
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// the mode that applies to this window, without a compositor or with the
+// swap turned off (params file line 7) the swap modes can't be used
+//------------------------------------------------------------------------------
+static unsigned int effective_mode(const window* win)
+{
+	unsigned int mode = g_presentMode;
+	if((presentSwapDamage == mode) || (presentSwap == mode))
+	{
+		if(win->headless)
+		{
+			return presentFinish;
+		}
+		if(win->no_swapbuffer_call)
+		{
+			return presentFlush;
+		}
+	}
+	return mode;
+}
+
+// the whole surface is opaque in fullscreen, or for an opaque window
+//------------------------------------------------------------------------------
+static void update_opaque_region(window* win, present_state* present)
+{
+	bool opaque = win->opaque || win->fullscreen;
+	if(present->region_set && (present->region_opaque == opaque) &&
+		(present->region_width == win->geometry.width) && (present->region_height == win->geometry.height))
+	{
+		return;
+	}
+
+	if(opaque) {
+		struct wl_region* region = wl_compositor_create_region(win->display->compositor);
+		wl_region_add(region, 0, 0,
+			      win->geometry.width,
+			      win->geometry.height);
+		wl_surface_set_opaque_region(win->surface, region);
+		wl_region_destroy(region);
+	} else {
+		wl_surface_set_opaque_region(win->surface, NULL);
+	}
+
+	present->region_set = true;
+	present->region_opaque = opaque;
+	present->region_width = win->geometry.width;
+	present->region_height = win->geometry.height;
+}
+
+// read the frame back into client memory, the way a capture or a remote
+// display would
+//------------------------------------------------------------------------------
+static void read_back(window* win, present_state* present)
+{
+	int width, height, bytes_per_pixel;
+	GLenum format, type;
+	render_target_size(win, width, height);
+	offscreen_read_format(win, format, type, bytes_per_pixel);
+
+	size_t size = (size_t)width * height * bytes_per_pixel;
+	if(size > present->pixels_size)
+	{
+		delete[] present->pixels;
+		present->pixels = new GLubyte[size];
+		present->pixels_size = size;
+	}
+	glReadPixels(0, 0, width, height, format, type, present->pixels);
+}
+
+// present the frame the scene just drew
+//------------------------------------------------------------------------------
+void present_frame(window* win)
+{
+	display* display = win->display;
+
+	if(NULL == win->present)
+	{
+		win->present = new present_state;
+		win->present->region_set = false;
+		win->present->pixels = NULL;
+		win->present->pixels_size = 0;
+	}
+
+	uint64_t start = monotonic_now_us();
+
+	// a multisampled offscreen target is resolved first, so a readback
+	// reads the finished frame
+	offscreen_resolve(win);
+	readback_frame(win);
+
+	switch(effective_mode(win))
+	{
+		case presentSwapDamage:
+		{
+			update_opaque_region(win, win->present);
+
+			EGLint* rects = NULL;
+			int count = damage_swap_rects(win, rects);
+			if(display->swap_buffers_with_damage && count)
+			{
+				display->swap_buffers_with_damage(display->egl.dpy, win->egl_surface, rects, count);
+			}
+			else
+			{
+				eglSwapBuffers(display->egl.dpy, win->egl_surface);
+			}
+			break;
+		}
+
+		case presentSwap:
+			update_opaque_region(win, win->present);
+			eglSwapBuffers(display->egl.dpy, win->egl_surface);
+			break;
+
+		case presentFlush:
+			glFlush();
+			break;
+
+		case presentFinish:
+			glFinish();
+			break;
+
+		case presentReadback:
+			read_back(win, win->present);
+			break;
+
+		default:
+			printf("Invalid present mode\n");
+			assert(0);
+			break;
+	}
+	damage_end_frame(win);
+	offscreen_next_target(win);
+
+	win->present_time_us = (uint32_t)(monotonic_now_us() - start);
+	win->present_time_sum_us += win->present_time_us;
+	win->frames++;
+}
@@ -0,0 +1,46 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __PRESENTER_H__
+#define __PRESENTER_H__
+
+// Presenter
+// Everything a scene does after its last draw call: the opaque region, the
+// swap or whatever replaces it, and the frame count. The time spent here is
+// measured on its own, so the cost of presenting (including vsync waits)
+// can be told apart from the cost of drawing.
+
+// how a frame is presented, params file line 27
+enum PresentModes {
+	presentSwapDamage = 0,	// eglSwapBuffersWithDamage with the scene's damage, when the driver has it
+	presentSwap = 1,		// eglSwapBuffers, the whole surface is damaged
+	presentFlush = 2,		// no swap, glFlush
+	presentFinish = 3,		// no swap, glFinish, meant for offscreen
+	presentReadback = 4,	// no swap, read the frame back with glReadPixels
+	presentModeCount,
+};
+
+// present the frame the scene just drew
+void present_frame(window* win);
+
+const char* present_mode_name(unsigned int mode);
+
+#endif // __PRESENTER_H__
@@ -0,0 +1,385 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+#include <algorithm>
+
+#include "main.h"
+#include "readback.h"
+#include "offscreen.h"
+#include "frame-check.h"
+#include "capture.h"
+
+// the longest a full ring waits for its oldest read, before giving up on it
+#define READBACK_WAIT_NS	1000000000ull
+
+// where the pixels of a read go
+#define READ_TO_CLIENT		0x1		// the readback's own copy
+#define READ_TO_CHECK		0x2		// the frame check, see frame-check.h
+#define READ_TO_CAPTURE		0x4		// the capture file, see capture.h
+
+struct readback_slot {
+	GLuint pbo;
+	GLsync fence;				// NULL when the slot is free
+	size_t size;				// the buffer's storage
+	uint64_t frame_id;
+	uint64_t issue_us;
+	int width, height, bytes_per_pixel;
+	unsigned int targets;		// READ_TO_*
+};
+
+struct readback_state {
+	bool async;
+	int depth;
+	readback_slot slots[MAX_READBACK_DEPTH];
+	int head;					// the slot the next read goes into
+	int pending;				// reads in flight, the oldest is head - pending
+	uint32_t frames_since_read;
+
+	// the frame that was read last, in client memory
+	GLubyte* pixels;
+	size_t pixels_size;
+	int width, height;
+
+	// stats since the readback was started
+	uint64_t start_us;
+	uint64_t reads, bytes;
+	uint64_t stalls;			// the ring was full and the render thread waited
+	uint64_t thread_sum_us;		// time the render thread spent on readback
+	uint32_t thread_max_us;
+	uint64_t latency_sum_us;	// from the read being issued to the pixels arriving
+	uint64_t latency_frames_sum;
+};
+
+static const char* g_readback_mode_names[readbackModeCount] = {
+	"off",
+	"sync",
+	"async",
+};
+
+//------------------------------------------------------------------------------
+const char* readback_mode_name(unsigned int mode)
+{
+	if(mode >= readbackModeCount)
+	{
+		return "unknown";
+	}
+	return g_readback_mode_names[mode];
+}
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+static GLubyte* client_buffer(readback_state* state, size_t size)
+{
+	if(size > state->pixels_size)
+	{
+		delete[] state->pixels;
+		state->pixels = new GLubyte[size];
+		state->pixels_size = size;
+	}
+	return state->pixels;
+}
+
+// the pixels of a frame arrived in client memory
+//------------------------------------------------------------------------------
+static void frame_read(window* win, readback_state* state, uint64_t frame_id, uint64_t issue_us, size_t size)
+{
+	state->reads++;
+	state->bytes += size;
+	state->latency_sum_us += monotonic_now_us() - issue_us;
+	state->latency_frames_sum += win->frame_id - frame_id;
+}
+
+// hand the pixels of a frame to everything that wanted it
+//------------------------------------------------------------------------------
+static void deliver_frame(window* win, readback_state* state, unsigned int targets, const void* pixels,
+						  uint64_t frame_id, int width, int height, int bytes_per_pixel, size_t size)
+{
+	if(targets & READ_TO_CHECK)
+	{
+		unsigned char* copy = frame_check_buffer(size);
+		if(copy)
+		{
+			memcpy(copy, pixels, size);
+			frame_check_submit(win, frame_id, copy, width, height, bytes_per_pixel);
+		}
+	}
+	if(targets & READ_TO_CAPTURE)
+	{
+		unsigned char* copy = capture_buffer(size);
+		if(copy)
+		{
+			memcpy(copy, pixels, size);
+			capture_submit(win, frame_id, copy, width, height, bytes_per_pixel);
+		}
+	}
+	if((targets & READ_TO_CLIENT) && (pixels != state->pixels))
+	{
+		memcpy(client_buffer(state, size), pixels, size);
+	}
+}
+
+// copy the oldest read in flight to client memory, 'wait' blocks until the
+// GPU has written it. Returns false when it isn't there yet
+//------------------------------------------------------------------------------
+static bool collect_oldest(window* win, readback_state* state, bool wait)
+{
+	readback_slot& slot = state->slots[(state->head - state->pending + state->depth) % state->depth];
+
+	GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? READBACK_WAIT_NS : 0);
+	if(GL_TIMEOUT_EXPIRED == status)
+	{
+		if(wait)
+		{
+			printf("Readback of frame %llu timed out, dropping it\n", (unsigned long long)slot.frame_id);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = NULL;
+	state->pending--;
+
+	if((GL_ALREADY_SIGNALED != status) && (GL_CONDITION_SATISFIED != status))
+	{
+		return true;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+	if(mapped)
+	{
+		deliver_frame(win, state, slot.targets, mapped, slot.frame_id, slot.width, slot.height, slot.bytes_per_pixel, slot.size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		frame_read(win, state, slot.frame_id, slot.issue_us, slot.size);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+// start reading the current frame into the next buffer of the ring
+//------------------------------------------------------------------------------
+static void issue_read(window* win, readback_state* state, GLenum format, GLenum type,
+					   int bytes_per_pixel, size_t size, unsigned int targets)
+{
+	// the ring is full, the render thread has to wait for the oldest read
+	if(state->pending == state->depth)
+	{
+		state->stalls++;
+		collect_oldest(win, state, true);
+	}
+
+	readback_slot& slot = state->slots[state->head];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	if(slot.size != size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		slot.size = size;
+	}
+	glReadPixels(0, 0, state->width, state->height, format, type, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame_id = win->frame_id;
+	slot.issue_us = monotonic_now_us();
+	slot.width = state->width;
+	slot.height = state->height;
+	slot.bytes_per_pixel = bytes_per_pixel;
+	slot.targets = targets;
+	state->head = (state->head + 1) % state->depth;
+	state->pending++;
+}
+
+//------------------------------------------------------------------------------
+static readback_state* create_state(window* win, bool async)
+{
+	readback_state* state = new readback_state;
+	memset(state, 0, sizeof(*state));
+	state->async = async;
+	state->depth = std::min(std::max((int)g_readbackDepth, 1), MAX_READBACK_DEPTH);
+	state->start_us = monotonic_now_us();
+	if(async)
+	{
+		for(int i=0; i<state->depth; i++)
+		{
+			glGenBuffers(1, &state->slots[i].pbo);
+		}
+	}
+	return state;
+}
+
+// after the scene's last draw call, before the swap: collects the reads
+// that have finished and starts this frame's read when it's due
+//------------------------------------------------------------------------------
+void readback_frame(window* win)
+{
+	// the frame check and the capture read back on their own when the
+	// readback is off
+	unsigned int mode = g_readbackMode;
+	if((readbackOff == mode) && (frame_check_enabled() || capture_enabled()))
+	{
+		mode = readbackAsync;
+	}
+	if((readbackOff == mode) || (mode >= readbackModeCount))
+	{
+		readback_stop(win);
+		return;
+	}
+
+	bool async = (readbackAsync == mode);
+	if(async && (win->display->egl.client_version < 3))
+	{
+		if(!win->readback)
+		{
+			printf("Asynchronous readback needs OpenGL ES 3, reading synchronously\n");
+		}
+		async = false;
+	}
+
+	// a new mode or ring depth starts over
+	readback_state* state = win->readback;
+	if(state && ((state->async != async) || (state->async && (state->depth != std::min(std::max((int)g_readbackDepth, 1), MAX_READBACK_DEPTH)))))
+	{
+		readback_stop(win);
+		state = NULL;
+	}
+	if(!state)
+	{
+		state = create_state(win, async);
+		win->readback = state;
+	}
+
+	uint64_t start = monotonic_now_us();
+	bool busy = false;
+
+	// whatever finished since the last frame, without waiting
+	while(state->pending && collect_oldest(win, state, false))
+	{
+		busy = true;
+	}
+
+	unsigned int targets = 0;
+	if(g_readbackMode && (++state->frames_since_read >= std::max(g_readbackInterval, 1u)))
+	{
+		state->frames_since_read = 0;
+		targets |= READ_TO_CLIENT;
+	}
+	if(frame_check_wanted(win))
+	{
+		targets |= READ_TO_CHECK;
+	}
+	if(capture_wanted(win))
+	{
+		targets |= READ_TO_CAPTURE;
+	}
+	if(targets)
+	{
+		busy = true;
+
+		int bytes_per_pixel;
+		GLenum format, type;
+		render_target_size(win, state->width, state->height);
+		offscreen_read_format(win, format, type, bytes_per_pixel);
+		size_t size = (size_t)state->width * state->height * bytes_per_pixel;
+
+		if(state->async)
+		{
+			issue_read(win, state, format, type, bytes_per_pixel, size, targets);
+		}
+		else
+		{
+			GLubyte* pixels = client_buffer(state, size);
+			glReadPixels(0, 0, state->width, state->height, format, type, pixels);
+			deliver_frame(win, state, targets, pixels, win->frame_id, state->width, state->height, bytes_per_pixel, size);
+			frame_read(win, state, win->frame_id, start, size);
+		}
+	}
+
+	if(busy)
+	{
+		uint32_t elapsed = (uint32_t)(monotonic_now_us() - start);
+		state->thread_sum_us += elapsed;
+		state->thread_max_us = std::max(state->thread_max_us, elapsed);
+	}
+}
+
+// finish the reads in flight, print the readback stats and release the
+// buffers, with the surface's context current
+//------------------------------------------------------------------------------
+void readback_stop(window* win)
+{
+	readback_state* state = win->readback;
+	if(!state)
+	{
+		return;
+	}
+	win->readback = NULL;
+
+	while(state->pending)
+	{
+		collect_oldest(win, state, true);
+	}
+	for(int i=0; i<state->depth; i++)
+	{
+		if(state->slots[i].pbo)
+		{
+			glDeleteBuffers(1, &state->slots[i].pbo);
+		}
+	}
+
+	if(state->reads)
+	{
+		double seconds = (monotonic_now_us() - state->start_us) / 1000000.0;
+		if(win->surface_index)
+		{
+			printf("[surface %d] ", win->surface_index);
+		}
+		printf("Readback (%s", state->async ? "async" : "sync");
+		if(state->async)
+		{
+			printf(", %d buffers", state->depth);
+		}
+		printf("): %llu frames of (%d,%d), %.1f MB/s, latency %.3f ms / %.1f frames, render thread %.3f ms per read (max %.3f ms), %llu stalls\n",
+			(unsigned long long)state->reads,
+			state->width, state->height,
+			seconds > 0.0 ? state->bytes / seconds / 1000000.0 : 0.0,
+			(double)state->latency_sum_us / state->reads / 1000.0,
+			(double)state->latency_frames_sum / state->reads,
+			(double)state->thread_sum_us / state->reads / 1000.0,
+			state->thread_max_us / 1000.0,
+			(unsigned long long)state->stalls);
+	}
+
+	delete[] state->pixels;
+	delete state;
+}
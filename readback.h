@@ -0,0 +1,52 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __READBACK_H__
+#define __READBACK_H__
+
+// Frame readback
+// Copies every g_readbackInterval-th frame (params file line 43) back to
+// client memory, the way screen capture and recording do. The synchronous
+// mode reads with glReadPixels() and waits for the GPU to get there. The
+// asynchronous mode reads into a ring of g_readbackDepth (line 44) pixel
+// pack buffers and maps each one once its fence has signalled, usually a few
+// frames later, so the render thread only waits when the whole ring is still
+// in flight. It needs OpenGL ES 3, without it the reads are synchronous.
+enum ReadbackModes {
+	readbackOff = 0,
+	readbackSync,
+	readbackAsync,
+	readbackModeCount,
+};
+
+#define MAX_READBACK_DEPTH	8
+
+// after the scene's last draw call, before the swap: collects the reads
+// that have finished and starts this frame's read when it's due
+void readback_frame(window* win);
+
+// finish the reads in flight, print the readback stats and release the
+// buffers, with the surface's context current
+void readback_stop(window* win);
+
+const char* readback_mode_name(unsigned int mode);
+
+#endif // __READBACK_H__
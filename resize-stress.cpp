@@ -0,0 +1,206 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+#include <algorithm>
+
+#include "main.h"
+#include "resize-stress.h"
+
+// the schedule goes from the window size to the minimum in this many steps
+#define RESIZE_STEPS	8
+
+// what a frame was, for the frame time accounting
+enum FrameKinds {
+	frameSteady = 0,
+	frameResize,		// the surface got a new size at its start
+	frameAfterResize,	// the one after, the compositor gets the new buffer
+	frameKindCount,
+};
+
+struct frame_cost {
+	uint64_t frames;
+	uint64_t frame_sum_us;
+	uint32_t frame_max_us;
+	uint64_t present_sum_us;
+};
+
+struct resize_stress {
+	uint64_t resizes;
+	uint32_t frames_since_resize;
+	int step;						// position in the schedule
+	bool fullscreen_reported;
+
+	// the frame that is being drawn, it's accounted when the next one starts
+	uint64_t frame_start_us;
+	FrameKinds kind;
+	frame_cost costs[frameKindCount];
+};
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// the next size, between the minimum and the configured window size
+//------------------------------------------------------------------------------
+static void next_size(window* win, resize_stress* resize, int& width, int& height)
+{
+	int max_width = std::max(win->window_size.width, 1);
+	int max_height = std::max(win->window_size.height, 1);
+	int min_width = std::min(std::max(g_resizeMinWidth, 1), max_width);
+	int min_height = std::min(std::max(g_resizeMinHeight, 1), max_height);
+
+	if(resizeSchedule == g_resizeStress)
+	{
+		resize->step = (resize->step + 1) % (2 * RESIZE_STEPS);
+		int t = (resize->step <= RESIZE_STEPS) ? resize->step : 2 * RESIZE_STEPS - resize->step;
+		width = max_width - (max_width - min_width) * t / RESIZE_STEPS;
+		height = max_height - (max_height - min_height) * t / RESIZE_STEPS;
+	}
+	else
+	{
+		uint32_t seed = (uint32_t)win->frame_id * 2654435761u + win->surface_index;
+		seed = seed * 1664525u + 1013904223u;
+		width = min_width + (seed >> 8) % (max_width - min_width + 1);
+		seed = seed * 1664525u + 1013904223u;
+		height = min_height + (seed >> 8) % (max_height - min_height + 1);
+	}
+}
+
+// at the start of every frame, before the scene draws: resizes the surface
+// when it's due and accounts the previous frame
+//------------------------------------------------------------------------------
+void resize_stress_frame(window* win)
+{
+	resize_stress* resize = win->resize;
+
+	// turned off while running, back to the configured size
+	if((resizeOff == g_resizeStress) || (g_resizeStress >= resizeModeCount))
+	{
+		if(resize)
+		{
+			resize_stress_stop(win);
+			if((win->geometry.width != win->window_size.width) || (win->geometry.height != win->window_size.height))
+			{
+				resize_surface(win, win->window_size.width, win->window_size.height);
+			}
+		}
+		return;
+	}
+
+	if(NULL == resize)
+	{
+		resize = new resize_stress;
+		memset(resize, 0, sizeof(*resize));
+		win->resize = resize;
+	}
+
+	// the compositor owns the size of a fullscreen surface
+	if(win->fullscreen)
+	{
+		if(!resize->fullscreen_reported)
+		{
+			printf("Resize stress needs a windowed surface\n");
+			resize->fullscreen_reported = true;
+		}
+		return;
+	}
+
+	// the previous frame ends where this one starts
+	uint64_t now = monotonic_now_us();
+	if(resize->frame_start_us)
+	{
+		frame_cost& cost = resize->costs[resize->kind];
+		uint32_t frame_us = (uint32_t)(now - resize->frame_start_us);
+		cost.frames++;
+		cost.frame_sum_us += frame_us;
+		cost.frame_max_us = std::max(cost.frame_max_us, frame_us);
+		cost.present_sum_us += win->present_time_us;
+	}
+	resize->frame_start_us = now;
+
+	FrameKinds previous = resize->kind;
+	resize->kind = (frameResize == previous) ? frameAfterResize : frameSteady;
+
+	if(++resize->frames_since_resize < std::max(g_resizeInterval, 1u))
+	{
+		return;
+	}
+	resize->frames_since_resize = 0;
+
+	int width, height;
+	next_size(win, resize, width, height);
+	if((width == win->geometry.width) && (height == win->geometry.height))
+	{
+		return;
+	}
+
+	resize_surface(win, width, height);
+	resize->resizes++;
+	resize->kind = frameResize;
+}
+
+//------------------------------------------------------------------------------
+static double mean_ms(uint64_t sum_us, uint64_t count)
+{
+	return count ? (double)sum_us / count / 1000.0 : 0.0;
+}
+
+// print the resize frame costs and release the state
+//------------------------------------------------------------------------------
+void resize_stress_stop(window* win)
+{
+	resize_stress* resize = win->resize;
+	if(NULL == resize)
+	{
+		return;
+	}
+	win->resize = NULL;
+
+	if(resize->resizes)
+	{
+		static const char* kind_names[frameKindCount] = { "other", "resize", "after resize" };
+
+		if(win->surface_index)
+		{
+			printf("[surface %d] ", win->surface_index);
+		}
+		printf("Resize stress: %llu resizes\n", (unsigned long long)resize->resizes);
+		for(int i=0; i<frameKindCount; i++)
+		{
+			const frame_cost& cost = resize->costs[i];
+			printf("  %-12s frames %6llu: frame time mean %.3f ms, max %.3f ms, present mean %.3f ms\n",
+				kind_names[i],
+				(unsigned long long)cost.frames,
+				mean_ms(cost.frame_sum_us, cost.frames),
+				cost.frame_max_us / 1000.0,
+				mean_ms(cost.present_sum_us, cost.frames));
+		}
+	}
+	delete resize;
+}
@@ -0,0 +1,47 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __RESIZE_STRESS_H__
+#define __RESIZE_STRESS_H__
+
+// Resize stress
+// Every g_resizeInterval frames (params file line 33) the surface gets a new
+// size between g_resizeMinWidth x g_resizeMinHeight (lines 34, 35) and the
+// configured window size. The Wayland window, the offscreen buffer and the
+// viewport follow, so the driver reallocates the window's buffers and the
+// compositor imports new ones. The frame times of the resize frames and of
+// the frames right after are kept apart from the others, to show what a
+// reallocation costs.
+enum ResizeModes {
+	resizeOff = 0,
+	resizeSchedule,		// from the window size down to the minimum and back, in steps
+	resizeRandom,		// random sizes, the same ones for the same frames of every run
+	resizeModeCount,
+};
+
+// at the start of every frame, before the scene draws: resizes the surface
+// when it's due and accounts the previous frame
+void resize_stress_frame(window* win);
+
+// print the resize frame costs and release the state
+void resize_stress_stop(window* win);
+
+#endif // __RESIZE_STRESS_H__
@@ -20,9 +20,8 @@
 // 
 // Please see the readme.txt for further license information.
 #include <stdio.h>
-#include "shaders.h"
 
-#include "store1k.h"	// needed for HEADER_PIXEL macro
+#include "shaders.h"
 
 //------------------------------------------------------------------------------
 GLuint create_shader(window *window, const char *source, GLenum shader_type)
@@ -50,118 +49,10 @@ GLuint create_shader(window *window, const char *source, GLenum shader_type)
 	return shader;
 }
 
-// generate a checkerboard texture 
-//------------------------------------------------------------------------------
-void checkerBoardTexture(GLuint& textureID, int checkImageWidth, int checkImageHeight, int alpha_style)
-{
-	GLint max_size = 0;
-	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
-	printf("Max texture size: %d\n", max_size);
-	
-
-	GLubyte checkImage[checkImageWidth][checkImageHeight][4];
-	printf("doing checkerboard \n");
-	fflush(stdout);
-
-
-	int c;
-	for(int i=0; i< checkImageHeight; i++) {
-		for(int j=0; j<checkImageWidth; j++) {
-		
-			c = ( (((i&0x8)==0) ^ (((j&0x8))==0))) * 255;
-			checkImage[i][j][0] = (GLubyte) c;
-			checkImage[i][j][1] = (GLubyte) c;
-			checkImage[i][j][2] = (GLubyte) c;
-			checkImage[i][j][3] = (GLubyte) 255;
-		}
-	}
-
-	printf("Generated checkerboard ok \n");
-	fflush(stdout);
-
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	glActiveTexture(GL_TEXTURE0);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);	
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, checkImageWidth, checkImageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, checkImage);
-}
-
-
-// register textures
+// upload decoded RGBA8 pixels as a repeating, linearly filtered texture
 //------------------------------------------------------------------------------
-void registerTexture(GLuint& textureID, int image_width, int image_height, char* pimage_data, int alpha_style, bool digits)
+void uploadTexture(GLuint& textureID, int image_width, int image_height, const GLubyte* pixels)
 {
-#ifdef CHECKERBOARD_TEXTURES
-	// hard-coded checkerboard texture
-	// if you want to remove loading as a feature
-	int c;
-	for(int i=0; i< checkImageHeight; i++) {
-		for(int j=0; j<checkImageWidth; j++) {
-		
-			c = ((((i&0x8)==0)^((j&0x8))==0)) * 255;
-			checkImage[i][j][0] = (GLubyte) c;
-			checkImage[i][j][1] = (GLubyte) c;
-			checkImage[i][j][2] = (GLubyte) c;
-			checkImage[i][j][3] = (GLubyte) 255;
-		}
-	}
-#endif
-
-
-	GLubyte raw_image_data[image_width][image_height][4];
-	memset(raw_image_data, 255, image_width*image_height*4);
-
-	char* pIndex = (char*)raw_image_data;
-
-	if(0==alpha_style)
-	{
-		//printf("alpha=off\n");
-		for(int x=0; x<(image_width*image_height); x++)
-		{
-			HEADER_PIXEL(pimage_data, pIndex);
-			pIndex+=4;
-		}
-	}
-	else
-	{
-		if(1==alpha_style) 
-		{
-			for(int x=0; x<(image_width*image_height); x++)
-			{
-				HEADER_PIXEL(pimage_data, pIndex);
-
-				if((pIndex[0]>= 5 && pIndex[1]>= 5 && pIndex[2]>= 5) )
-					pIndex[3]=0x0;
-				else
-					pIndex[3]=pIndex[0];		
-
-				pIndex+=4;
-			}		
-		}
-		if(2==alpha_style)
-		{
-			for(int x=0; x<(image_width*image_height); x++)
-			{
-				HEADER_PIXEL(pimage_data, pIndex);
-
-				if((pIndex[0]== -1 && pIndex[1]== -1 && pIndex[2]== -1) )
-					pIndex[3]=0x0;
-				else
-					pIndex[3]=pIndex[0];
-
-				pIndex+=4;
-			}						
-		}
-	}
-
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
@@ -174,10 +65,5 @@ void registerTexture(GLuint& textureID, int image_width, int image_height, char*
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	
-#ifdef CHECKERBOARD_TEXTURES
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, checkImageWidth, checkImageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, checkImage);
-#else
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, raw_image_data);
-#endif
-
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
@@ -239,9 +239,75 @@ const char* const frag_shader_single_color =
 "}\n";	
 
 
+// post-process chain shaders, see post-process.h
+// every pass is a fullscreen quad, the texture coordinates come from the
+// position so the passes don't flip the image
+const char* const vert_shader_post =
+"attribute vec4 pos;\n"
+"varying vec2 v_texcoord1;\n"
+"void main() {\n"
+"  gl_Position = vec4(pos.xy, 0.0, 1.0);\n"
+"  v_texcoord1 = pos.xy * 0.5 + 0.5;\n"
+"}\n";
+
+// half size: 4 bilinear taps cover the 4x4 source pixels around the output
+// pixel. The bright pass of the bloom keeps the pixels above the threshold
+const char* const frag_shader_post_downsample =
+"precision mediump float;\n"
+"varying vec2 v_texcoord1;\n"
+"uniform sampler2D texSampler1;\n"
+"uniform vec2 texel;\n"
+"uniform float threshold;\n"
+"void main() {\n"
+"  vec4 color = texture2D(texSampler1, v_texcoord1 + vec2(-texel.x, -texel.y));\n"
+"  color += texture2D(texSampler1, v_texcoord1 + vec2( texel.x, -texel.y));\n"
+"  color += texture2D(texSampler1, v_texcoord1 + vec2(-texel.x,  texel.y));\n"
+"  color += texture2D(texSampler1, v_texcoord1 + vec2( texel.x,  texel.y));\n"
+"  color *= 0.25;\n"
+"  float luma = dot(color.rgb, vec3(0.299, 0.587, 0.114));\n"
+"  gl_FragColor = vec4(color.rgb * step(threshold, luma), 1.0);\n"
+"}\n";
+
+// one direction of a separable 9 tap Gaussian, blur_step is one texel
+// along the row or the column
+const char* const frag_shader_post_blur =
+"precision mediump float;\n"
+"varying vec2 v_texcoord1;\n"
+"uniform sampler2D texSampler1;\n"
+"uniform vec2 blur_step;\n"
+"void main() {\n"
+"  vec2 tc = v_texcoord1;\n"
+"  vec4 sum = texture2D(texSampler1, tc) * 0.2270270270;\n"
+"  sum += (texture2D(texSampler1, tc + 1.0*blur_step) + texture2D(texSampler1, tc - 1.0*blur_step)) * 0.1945945946;\n"
+"  sum += (texture2D(texSampler1, tc + 2.0*blur_step) + texture2D(texSampler1, tc - 2.0*blur_step)) * 0.1216216216;\n"
+"  sum += (texture2D(texSampler1, tc + 3.0*blur_step) + texture2D(texSampler1, tc - 3.0*blur_step)) * 0.0540540541;\n"
+"  sum += (texture2D(texSampler1, tc + 4.0*blur_step) + texture2D(texSampler1, tc - 4.0*blur_step)) * 0.0162162162;\n"
+"  gl_FragColor = sum;\n"
+"}\n";
+
+// the last pass, into the frame: the scene with the blurred image added
+// (bloom) or the blurred image alone, then the optional tone mapping
+const char* const frag_shader_post_combine =
+"precision mediump float;\n"
+"varying vec2 v_texcoord1;\n"
+"uniform sampler2D texSampler1;\n"
+"uniform sampler2D texSampler2;\n"
+"uniform float bloom;\n"
+"uniform float tonemap;\n"
+"void main() {\n"
+"  vec3 blurred = texture2D(texSampler2, v_texcoord1).rgb;\n"
+"  vec3 color = blurred;\n"
+"  if(bloom > 0.0) {\n"
+"    color = texture2D(texSampler1, v_texcoord1).rgb + bloom * blurred;\n"
+"  }\n"
+"  if(tonemap > 0.0) {\n"
+"    color = vec3(1.0) - exp(-1.5 * color);\n"
+"  }\n"
+"  gl_FragColor = vec4(color, 1.0);\n"
+"}\n";
+
 GLuint create_shader(window *window, const char *source, GLenum shader_type);
-void registerTexture(GLuint& textureID, int image_width, int image_height, char* pimage_data, int alpha_style, bool digits=false);
-void checkerBoardTexture(GLuint& textureID, int checkImageWidth, int checkImageHeight, int alpha_style);
+void uploadTexture(GLuint& textureID, int image_width, int image_height, const GLubyte* pixels);
 
 // GEOMETRY
 static const GLfloat pyramid_verts[] = {
@@ -33,17 +33,18 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
-#include <sys/time.h>	// gettimeofday
 #include <algorithm>	// std::max
 
 #include "simple-dial.h"
 
 #include "shaders.h" // quad_verts/etc
 #include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
 
 // textures
-#include "needle.h"
-#include "dialface.h"
+#include "assets.h"
 
 // glm math library
 #include "glm/vec3.hpp"
@@ -100,10 +101,13 @@ void initialize_simpleDial(window *window)
 	// load textures
 	if(0==g_dialTexID) 
 	{
-		registerTexture(g_dialTexID, image_dial::width, image_dial::height, image_dial::header_data, 2);
+		uploadTexture(g_dialTexID, asset_dial_width, asset_dial_height, asset_dial_pixels);
+	}
+
+	if(0==g_needleTexID) 
+	{
+		uploadTexture(g_needleTexID, asset_needle_width, asset_needle_height, asset_needle_pixels);
 	}
-	
-	registerTexture(g_needleTexID, image_needle::width, image_needle::height, image_needle::header_data, 1);
 }
 
 
@@ -112,11 +116,11 @@ void initialize_simpleDial(window *window)
 void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 
-	static bool first_frame = true;
-	static float left_dial_angle = 0.0f;
-	static GLfloat angle = 0.0f;
+	// one set per render thread
+	static thread_local bool first_frame = true;
+	static thread_local float left_dial_angle = 0.0f;
+	static thread_local GLfloat angle = 0.0f;
 
 	glUseProgram(win->gl_tex.program);
 
@@ -125,13 +129,8 @@ void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now
 	glEnable(GL_BLEND);
 	
 	glActiveTexture(GL_TEXTURE0);	
-	glBindTexture(GL_TEXTURE_2D, g_dialTexID);
 
-	struct wl_region *region;
-	EGLint rect[4];
-	EGLint buffer_age = 0;
-	struct timeval tv;
-	static struct timeval Startuptv;
+	static thread_local uint32_t startup_time = 0;
 
 	assert(win->callback == callback);
 	win->callback = NULL;
@@ -140,22 +139,23 @@ void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now
 		wl_callback_destroy(callback);
 
 
+	// timer for moving objects and timing frame
+	float fps = calculate_fps(win, "dials", time_now);
+
+	// the dial faces don't change, only the needles and the fps counter do
+	damage_begin(win);
+
 	if(first_frame) 
 	{
 		// record the initial startup time
 		// so that no matter what happens, our dials will spin smoothly
 		// and independent of framerate or hitches
-		gettimeofday(&Startuptv, NULL);
+		startup_time = time_now;
 		first_frame = false;
 	}
 
-	// timer for moving objects and timing frame
-	float fps = calculate_fps(win, "dials", time_now);
-
-
-	// startup elapsed
-	gettimeofday(&tv, NULL);
-	long ElapsedTime = (tv.tv_sec-Startuptv.tv_sec) * 1000 + (tv.tv_usec-Startuptv.tv_usec) / 1000;	
+	// startup elapsed, follows the simulation clock when it is fixed
+	long ElapsedTime = (long)(time_now - startup_time);
 	
 	double bbR = 0.005;
 	double bbL = 0.1;
@@ -175,13 +175,9 @@ void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now
 		left_dial_angle = left_dial_angle - (int)(dd / 360.0) * 360;
 
 
-	if (display->swap_buffers_with_damage)
-		eglQuerySurface(display->egl.dpy, win->egl_surface,
-				EGL_BUFFER_AGE_EXT, &buffer_age);
-
-
-	glViewport(0, 0, win->geometry.width, win->geometry.height);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
 
 	// orthographic projection matrix	
 	float r=1.0f;
@@ -205,13 +201,9 @@ void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now
 		(GLfloat *)glm::value_ptr(view_matrix));
 
 
-	float aspect_ratio = (float) win->geometry.height / (float)win->geometry.width;
+	float aspect_ratio = (float) height / (float) width;
 	float shrink = 3.0f / 4.0f;	// aspect ratio of the needle texture
 
-	// set number of draw loops
-	// set the number of shader 'work' loops
-	glUniform1f(win->gl_tex.shader_loop_count, win->dialsShader_loop_count);
-
 
 	glVertexAttribPointer(win->gl_tex.pos, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
 	glVertexAttribPointer(win->gl_tex.col, 4, GL_FLOAT, GL_FALSE, 0, quad_colors);	
@@ -219,77 +211,83 @@ void draw_simpleDial(void *data, struct wl_callback *callback, uint32_t time_now
 	glEnableVertexAttribArray(win->gl_tex.pos);
 	glEnableVertexAttribArray(win->gl_tex.col);
 	glEnableVertexAttribArray(win->gl_tex.tex1);
-			
+
+	// dial faces
+	glm::mat4 identity_matrix(1.f);
+	glm::mat4 left_dial = glm::translate(identity_matrix, glm::vec3(-0.5f, 0.0f, 0.0f));
+	left_dial = glm::scale(left_dial, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));
+	glm::mat4 right_dial = glm::translate(identity_matrix, glm::vec3( 0.5f, 0.0f, 0.0f));
+	right_dial = glm::scale(right_dial, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));
+
+	// needles
+	glm::mat4 left_needle = glm::rotate(left_dial, left_dial_angle*(3.14159265f/180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	left_needle = glm::translate(left_needle, glm::vec3(0.0f, 0.5f, 0.0f));
+	left_needle = glm::scale(left_needle, glm::vec3(0.05f, 0.3f, 1.0f));
+	glm::mat4 right_needle = glm::rotate(right_dial, angle*(3.14159265f/180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	right_needle = glm::translate(right_needle, glm::vec3(0.0f, 0.5f, 0.0f));
+	right_needle = glm::scale(right_needle, glm::vec3(0.05f, 0.3f, 1.0f));
+
+	damage_add_quad(win, glm::value_ptr(_ortho_matrix * view_matrix * left_needle));
+	damage_add_quad(win, glm::value_ptr(_ortho_matrix * view_matrix * right_needle));
+	float digits_x0, digits_y0, digits_x1, digits_y1;
+	g_TextRender.DigitsBounds(fps, digits_x0, digits_y0, digits_x1, digits_y1);
+	damage_add_ndc(win, digits_x0, digits_y0, digits_x1, digits_y1);
+
+	// partial redraw: the rest of the back buffer still holds the dial
+	// faces from when it was last drawn, only the out of date parts are
+	// redrawn, one scissored pass each
+	EGLint repaint[4*MAX_REPAINT_RECTS];
+	int repaint_count = 0;
+	bool partial = g_partialRedraw && damage_repaint_rects(win, repaint, repaint_count);
+	if(partial)
+	{
+		glEnable(GL_SCISSOR_TEST);
+	}
+
+	for(int pass=0; pass<(partial ? repaint_count : 1); pass++)
+	{
+		// scissor and damage rects both start bottom-left
+		if(partial)
+		{
+			glScissor(repaint[4*pass+0], repaint[4*pass+1], repaint[4*pass+2], repaint[4*pass+3]);
+		}
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// set the number of shader 'work' loops
+		glUniform1f(win->gl_tex.shader_loop_count, win->dialsShader_loop_count);
+		glBindTexture(GL_TEXTURE_2D, g_dialTexID);
+
 		// left dial				
-		glm::mat4 model_matrix(1.f);
-		glm::mat4 identity_matrix(1.f);
-		model_matrix = glm::translate(identity_matrix, glm::vec3(-0.5f, 0.0f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));				
 		glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE,
-				   (GLfloat *) glm::value_ptr(model_matrix));	
+				   (GLfloat *) glm::value_ptr(left_dial));	
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 		// right dial
-		model_matrix = glm::translate(identity_matrix, glm::vec3( 0.5f, 0.0f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));				
 		glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE,
-				   (GLfloat *) glm::value_ptr(model_matrix));	
+				   (GLfloat *) glm::value_ptr(right_dial));	
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 
 		// left needle
 		glUniform1f(win->gl_tex.shader_loop_count, 0);	// no work for needles, keep them normal
-		model_matrix = glm::translate(identity_matrix, glm::vec3(-0.5f, 0.0f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));	
-		model_matrix = glm::rotate(model_matrix, left_dial_angle*(3.14159265f/180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		model_matrix = glm::translate(model_matrix, glm::vec3(0.0f, 0.5f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(0.05f, 0.3f, 1.0f));	
 		glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE,
-				   (GLfloat *) glm::value_ptr(model_matrix));	
+				   (GLfloat *) glm::value_ptr(left_needle));	
 
 		glBindTexture(GL_TEXTURE_2D, g_needleTexID);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 
 		// right needle
-		model_matrix = glm::translate(identity_matrix, glm::vec3( 0.5f, 0.0f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(aspect_ratio * shrink, 1.0f * shrink, 1.0f));	
-		model_matrix = glm::rotate(model_matrix, angle*(3.14159265f/180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		model_matrix = glm::translate(model_matrix, glm::vec3(0.0f, 0.5f, 0.0f));
-		model_matrix = glm::scale(model_matrix, glm::vec3(0.05f, 0.3f, 1.0f));					
 		glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE,
-				   (GLfloat *) glm::value_ptr(model_matrix));
+				   (GLfloat *) glm::value_ptr(right_needle));
 		glDrawArrays(GL_TRIANGLES, 0, 6);
+	}
+	glDisable(GL_SCISSOR_TEST);
 
 	// draw fps
 	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
 
-	// do not call eglSwapBuffers?
-	if(!win->no_swapbuffer_call)
-	{
-		if (win->opaque || win->fullscreen) {
-			region = wl_compositor_create_region(win->display->compositor);
-			wl_region_add(region, 0, 0,
-				      win->geometry.width,
-				      win->geometry.height);
-			wl_surface_set_opaque_region(win->surface, region);
-			wl_region_destroy(region);
-		} else {
-			wl_surface_set_opaque_region(win->surface, NULL);
-		}
-
-		if (display->swap_buffers_with_damage && buffer_age > 0) {
-			rect[0] = win->geometry.width / 4 - 1;
-			rect[1] = win->geometry.height / 4 - 1;
-			rect[2] = win->geometry.width / 2 + 2;
-			rect[3] = win->geometry.height / 2 + 2;
-			display->swap_buffers_with_damage(display->egl.dpy,
-							  win->egl_surface,
-							  rect, 1);
-		} else {
-			eglSwapBuffers(display->egl.dpy, win->egl_surface);
-		}
-	}
-	win->frames++;
+	// swap, or whatever the present mode does instead
+	present_frame(win);
 
 }
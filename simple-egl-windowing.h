@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <atomic>
 
 #include <linux/input.h>
 
@@ -59,7 +60,9 @@ typedef EGLBoolean (EGLAPIENTRYP PFNEGLSWAPBUFFERSWITHDAMAGEEXTPROC)(EGLDisplay
 #define EGL_BUFFER_AGE_EXT			0x313D
 #endif
 
-static int running = 1;
+// cleared by the signal handler, ESC and request_exit(), the render threads
+// poll it, see main.cpp
+extern std::atomic<int> running;
 
 static output* get_default_output(display *display)
 {
@@ -74,31 +77,62 @@ static output* get_default_output(display *display)
 	return NULL;
 }
 
+// window color formats, params file line 28
+struct color_format {
+	const char* name;
+	EGLint red, green, blue, alpha;
+};
+
+static const color_format g_color_formats[] = {
+	{ "RGBA8888",		8, 8, 8, 8 },
+	{ "RGB565",			5, 6, 5, 0 },
+	{ "RGBA1010102",	10, 10, 10, 2 },
+};
+
+// one line description of an EGL config, for the log and the metrics files
+static void describe_egl_config(EGLDisplay dpy, EGLConfig conf, char* text, size_t size)
+{
+	EGLint id = 0, red = 0, green = 0, blue = 0, alpha = 0;
+	EGLint depth = 0, stencil = 0, samples = 0;
+
+	eglGetConfigAttrib(dpy, conf, EGL_CONFIG_ID, &id);
+	eglGetConfigAttrib(dpy, conf, EGL_RED_SIZE, &red);
+	eglGetConfigAttrib(dpy, conf, EGL_GREEN_SIZE, &green);
+	eglGetConfigAttrib(dpy, conf, EGL_BLUE_SIZE, &blue);
+	eglGetConfigAttrib(dpy, conf, EGL_ALPHA_SIZE, &alpha);
+	eglGetConfigAttrib(dpy, conf, EGL_DEPTH_SIZE, &depth);
+	eglGetConfigAttrib(dpy, conf, EGL_STENCIL_SIZE, &stencil);
+	eglGetConfigAttrib(dpy, conf, EGL_SAMPLES, &samples);
+	snprintf(text, size, "EGL config %d: R%d G%d B%d A%d, depth %d, stencil %d, samples %d",
+		id, red, green, blue, alpha, depth, stencil, samples);
+}
+
 static void init_egl(display *display, window *window)
 {
-	static const EGLint context_attribs[] = {
-		EGL_CONTEXT_CLIENT_VERSION, 2,
-		EGL_NONE
-	};
 	const char *extensions;
 
+	const color_format& format = g_color_formats[window->color_format];
+	EGLint alpha_size = window->opaque ? 0 : format.alpha;
+
 	EGLint config_attribs[] = {
 		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-		EGL_RED_SIZE, 8,
-		EGL_GREEN_SIZE, 8,
-		EGL_BLUE_SIZE, 8,
-		EGL_ALPHA_SIZE, 8,
-		EGL_DEPTH_SIZE, 24,
+		EGL_RED_SIZE, format.red,
+		EGL_GREEN_SIZE, format.green,
+		EGL_BLUE_SIZE, format.blue,
+		EGL_ALPHA_SIZE, alpha_size,
+		EGL_DEPTH_SIZE, window->depth_size,
+		EGL_STENCIL_SIZE, window->stencil_size,
+		EGL_SAMPLE_BUFFERS, window->samples ? 1 : 0,
+		EGL_SAMPLES, window->samples,
 		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
 		EGL_NONE
 	};
 
-	EGLint major, minor, n, count, i, size;
+	EGLint major, minor, n, count, i;
+	EGLint red, green, blue, alpha;
 	EGLConfig *configs;
 	EGLBoolean ret;
-
-	if (window->opaque || window->buffer_size == 16)
-		config_attribs[10] = 0;
+	char description[128];
 
 	display->egl.dpy = (EGLDisplay) weston_platform_get_egl_display(EGL_PLATFORM_WAYLAND_KHR,
 						display->display, NULL);
@@ -117,26 +151,37 @@ static void init_egl(display *display, window *window)
 
 	ret = eglChooseConfig(display->egl.dpy, config_attribs,
 			      configs, count, &n);
-	assert(ret && n >= 1);
+	if (!ret || n < 1) {
+		fprintf(stderr, "no EGL config with %s, depth %d, stencil %d, samples %d\n",
+			format.name, window->depth_size, window->stencil_size, window->samples);
+		exit(EXIT_FAILURE);
+	}
 
+	// eglChooseConfig() also returns deeper formats, sorted first, the
+	// color sizes have to match exactly; depth, stencil and samples are
+	// at least what was asked for, the smallest first
 	for (i = 0; i < n; i++) {
-		eglGetConfigAttrib(display->egl.dpy,
-				   configs[i], EGL_BUFFER_SIZE, &size);
-		if (window->buffer_size == size) {
+		eglGetConfigAttrib(display->egl.dpy, configs[i], EGL_RED_SIZE, &red);
+		eglGetConfigAttrib(display->egl.dpy, configs[i], EGL_GREEN_SIZE, &green);
+		eglGetConfigAttrib(display->egl.dpy, configs[i], EGL_BLUE_SIZE, &blue);
+		eglGetConfigAttrib(display->egl.dpy, configs[i], EGL_ALPHA_SIZE, &alpha);
+		if ((red == format.red) && (green == format.green) &&
+		    (blue == format.blue) && (alpha == alpha_size)) {
 			display->egl.conf = configs[i];
 			break;
 		}
 	}
 	free(configs);
 	if (display->egl.conf == NULL) {
-		fprintf(stderr, "did not find config with buffer size %d\n",
-			window->buffer_size);
+		fprintf(stderr, "did not find a %s config with depth %d, stencil %d, samples %d\n",
+			format.name, window->depth_size, window->stencil_size, window->samples);
 		exit(EXIT_FAILURE);
 	}
+	window->buffer_size = format.red + format.green + format.blue + alpha_size;
+	describe_egl_config(display->egl.dpy, display->egl.conf, description, sizeof(description));
+	printf("%s\n", description);
 
-	display->egl.ctx = eglCreateContext(display->egl.dpy,
-					    display->egl.conf,
-					    EGL_NO_CONTEXT, context_attribs);
+	display->egl.ctx = create_gles_context(display, EGL_NO_CONTEXT);
 	assert(display->egl.ctx);
 
 	display->swap_buffers_with_damage = NULL;
@@ -275,7 +320,9 @@ static void create_xdg_surface(window *window, display *display)
 
 static void create_ivi_surface(window *window, display *display)
 {
-	uint32_t id_ivisurf = IVI_SURFACE_ID + (uint32_t)getpid();
+	// extra surfaces are offset past the largest possible pid
+	uint32_t id_ivisurf = IVI_SURFACE_ID + (uint32_t)getpid() + 
+		(uint32_t)window->surface_index * 0x400000;
 	window->ivi_surface =
 		ivi_application_surface_create(display->ivi_application,
 					       id_ivisurf, window->surface);
@@ -305,8 +352,8 @@ static void create_ias_surface(window *window, display *display)
 			fprintf(stderr, "Failed to get default output when setting fullscreen mode.\n");
 		}
 	} else {
-		ias_surface_unset_fullscreen(display->window->shell_surface, 
-			display->window->geometry.width, display->window->geometry.height);
+		ias_surface_unset_fullscreen(window->shell_surface, 
+			window->geometry.width, window->geometry.height);
 		ias_shell_set_zorder(display->ias_shell, window->shell_surface, 0);
 	}
 }
@@ -317,6 +364,7 @@ static void create_surface(window *window)
 	EGLBoolean ret;
 
 	window->surface = wl_compositor_create_surface(display->compositor);
+	wl_surface_set_user_data(window->surface, window);
 
 	window->native =
 		wl_egl_window_create(window->surface,
@@ -487,15 +535,21 @@ static void keyboard_handle_keymap(void *data, wl_keyboard *keyboard,
 {
 }
 
+// keys act on the surface that has the keyboard focus
 static void keyboard_handle_enter(void *data, wl_keyboard *keyboard,
 		      uint32_t serial, wl_surface *surface,
 		      wl_array *keys)
 {
+	struct display *d = (display*)data;
+	if (surface)
+		d->keyboard_focus = (window*)wl_surface_get_user_data(surface);
 }
 
 static void keyboard_handle_leave(void *data, wl_keyboard *keyboard,
 		      uint32_t serial, wl_surface *surface)
 {
+	struct display *d = (display*)data;
+	d->keyboard_focus = NULL;
 }
 
 static void keyboard_handle_key(void *data, wl_keyboard *keyboard,
@@ -503,23 +557,26 @@ static void keyboard_handle_key(void *data, wl_keyboard *keyboard,
 		    uint32_t state)
 {
 	struct display *d = (display*)data;
+	struct window *win = d->keyboard_focus ? d->keyboard_focus : d->window;
 
-	static int count = 0;
+	// surfaces drawn by their own thread can't be changed from here
+	if (win->egl_context)
+		win = d->window;
 
-	count++;
-	if (count%2!=1)	
-		return; // we always get double-presses on keys
+	// every key sends a press and a release, only act on the press
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
 
 	// print the keycode for testing
 	//printf("key: %d state: %d\n", key, state);
 
 	if (key == KEY_F11 && state) {
 		if (d->shell) {
-			if (d->window->fullscreen) {
-				xdg_surface_unset_fullscreen(d->window->xdg_surface);				
+			if (win->fullscreen) {
+				xdg_surface_unset_fullscreen(win->xdg_surface);				
 			}
 			else
-				xdg_surface_set_fullscreen(d->window->xdg_surface, NULL);
+				xdg_surface_set_fullscreen(win->xdg_surface, NULL);
 		}
 	} 
 	else if (key == KEY_ESC && state) 
@@ -528,32 +585,32 @@ static void keyboard_handle_key(void *data, wl_keyboard *keyboard,
 	} 
 	else if (key == 46) //'c'	
 	{ 
-		swap_draw_case(d->window);	
+		swap_draw_case(win);	
 	} 
 	else if (key == 16) // 'q'
 	{
-		add_shader_loops(multiDrawArrays);
+		add_shader_loops(win, multiDrawArrays);
 	} 
 	else if(key == 30) // 'a'
 	{		
-		shrink_shader_loops(multiDrawArrays);
+		shrink_shader_loops(win, multiDrawArrays);
 	}
 	else if ((key == 78) || (key == 13)) //'+'
 	{ 
-		switch(g_draw_case)
+		switch(win->draw_case)
 		{
 			case simpleDial:
-				add_shader_loops(simpleDial);			
+				add_shader_loops(win, simpleDial);			
 				break;
 
 			case multiDrawArrays:
 			case singleDrawArrays:
 			case batchDrawArrays:
-				add_pyramids();				
+				add_pyramids(win);				
 				break;
 
 			case longShader:
-				add_shader_loops(longShader);				
+				add_shader_loops(win, longShader);				
 				break;
 
 			default:
@@ -564,20 +621,20 @@ static void keyboard_handle_key(void *data, wl_keyboard *keyboard,
 	} 
 	else if ((key == 74) || (key == 12)) //'-'
 	{ 
-		switch(g_draw_case)
+		switch(win->draw_case)
 		{
 			case simpleDial:
-				shrink_shader_loops(simpleDial);			
+				shrink_shader_loops(win, simpleDial);			
 				break;
 
 			case multiDrawArrays:
 			case singleDrawArrays:
 			case batchDrawArrays:
-				remove_pyramids();
+				remove_pyramids(win);
 				break;
 
 			case longShader:
-				shrink_shader_loops(longShader);
+				shrink_shader_loops(win, longShader);
 				break;
 			
 			default:
@@ -586,15 +643,15 @@ static void keyboard_handle_key(void *data, wl_keyboard *keyboard,
 		}		
 
 	} else if (d->ias_shell) {
-		if (d->window->fullscreen) {
-			ias_surface_set_fullscreen(d->window->shell_surface,
+		if (win->fullscreen) {
+			ias_surface_set_fullscreen(win->shell_surface,
 					get_default_output(d)->output);
 		} else {
 			;
-			ias_surface_unset_fullscreen(d->window->shell_surface, 
-				d->window->geometry.width, d->window->geometry.height);
+			ias_surface_unset_fullscreen(win->shell_surface, 
+				win->geometry.width, win->geometry.height);
 			ias_shell_set_zorder(d->ias_shell,
-					d->window->shell_surface, 0);
+					win->shell_surface, 0);
 		}	
 	}
 }
@@ -38,9 +38,12 @@
 
 #include "shaders.h" // quad_verts/etc
 #include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
 
 // textures
-#include "store1k.h"
+#include "assets.h"
 
 // glm math library
 #include "glm/vec3.hpp"
@@ -167,7 +170,10 @@ void initialize_simpleTexture(window *window)
 		glGetUniformLocation(window->gl_tex_blur.program, "blur_radius");	
 
 	// load textures
-	registerTexture(g_textureID, image_1k::width, image_1k::height, const_cast<char*>(image_1k::header_data), 2);
+	if(0==g_textureID) 
+	{
+		uploadTexture(g_textureID, asset_store1k_width, asset_store1k_height, asset_store1k_pixels);
+	}
 
 }
 
@@ -176,7 +182,6 @@ void initialize_simpleTexture(window *window)
 void draw_simpleTexture(void *data, struct wl_callback *callback, uint32_t time_now)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 
 	if(win->texture_flat_no_rotate)
 	{
@@ -196,9 +201,6 @@ void draw_simpleTexture(void *data, struct wl_callback *callback, uint32_t time_
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, g_textureID);
 
-	struct wl_region *region;
-	EGLint rect[4];
-	EGLint buffer_age = 0;
 
 	// callback and weston setup
 	assert(win->callback == callback);
@@ -209,13 +211,16 @@ void draw_simpleTexture(void *data, struct wl_callback *callback, uint32_t time_
 
 	// timer for moving objects and timing frame
 	float fps = calculate_fps(win, "simple_texture", time_now);
+
+	// everything moves, the whole surface is damaged
+	damage_begin(win);
+	damage_add_full(win);
 	
-	if (display->swap_buffers_with_damage)
-		eglQuerySurface(display->egl.dpy, win->egl_surface,
-				EGL_BUFFER_AGE_EXT, &buffer_age);
 
 
-	glViewport(0, 0, win->geometry.width, win->geometry.height);
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// orthographic projection matrix	
@@ -288,30 +293,6 @@ void draw_simpleTexture(void *data, struct wl_callback *callback, uint32_t time_
 	// handle flips/weston
 	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
 
-	if (win->opaque || win->fullscreen) {
-		region = wl_compositor_create_region(win->display->compositor);
-		wl_region_add(region, 0, 0,
-			      win->geometry.width,
-			      win->geometry.height);
-		wl_surface_set_opaque_region(win->surface, region);
-		wl_region_destroy(region);
-	} else {
-		wl_surface_set_opaque_region(win->surface, NULL);
-	}
-
-	if(!win->no_swapbuffer_call)
-	{
-		if (display->swap_buffers_with_damage && buffer_age > 0) {
-			rect[0] = win->geometry.width / 4 - 1;
-			rect[1] = win->geometry.height / 4 - 1;
-			rect[2] = win->geometry.width / 2 + 2;
-			rect[3] = win->geometry.height / 2 + 2;
-			display->swap_buffers_with_damage(display->egl.dpy,
-							  win->egl_surface,
-							  rect, 1);
-		} else {
-			eglSwapBuffers(display->egl.dpy, win->egl_surface);
-		}
-	}
-	win->frames++;
+	// swap, or whatever the present mode does instead
+	present_frame(win);
 }
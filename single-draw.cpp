@@ -39,6 +39,8 @@
 
 #include "shaders.h" // quad_verts/etc
 #include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
 
 // glm math library
 #include "glm/vec3.hpp"
@@ -95,12 +97,8 @@ void initialize_singleDrawArrays(window *window)
 void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t time_now)
 {
 	struct window *win = (window*)data;
-	struct display *display = win->display;
 
 	static const uint32_t speed_div = 5;
-	struct wl_region *region;
-	EGLint rect[4];
-	EGLint buffer_age = 0;
 
 	// callback and weston management
 	assert(win->callback == callback);
@@ -109,13 +107,13 @@ void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t ti
 	if (callback)
 		wl_callback_destroy(callback);
 
-	if (display->swap_buffers_with_damage)
-		eglQuerySurface(display->egl.dpy, win->egl_surface,
-				EGL_BUFFER_AGE_EXT, &buffer_age);
-
 	// timer for moving objects and timing frame
 	float fps = calculate_fps(win, "single_draw", time_now);
 
+	// everything moves, the whole surface is damaged
+	damage_begin(win);
+	damage_add_full(win);
+
 	GLfloat angle = (time_now / speed_div) % 360; // * M_PI / 180.0;
 	
 
@@ -129,12 +127,12 @@ void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t ti
 		(GLfloat *)glm::value_ptr(proj_matrix));
 
 	// view matrix - make frustum so it bounds the pyramid grid tightly
-	int maxdim = std::max(x_count, y_count);
-	float xCoord = x_count*1.5f - 1.0f;
-	float yCoord = y_count*1.5f - 1.0f;
+	int maxdim = std::max(win->x_count, win->y_count);
+	float xCoord = win->x_count*1.5f - 1.0f;
+	float yCoord = win->y_count*1.5f - 1.0f;
 
 	glm::vec3 v_eye(xCoord, yCoord, -3.0f * (maxdim/2));
-	glm::vec3 v_center(xCoord, yCoord, z_count*1.5f);
+	glm::vec3 v_center(xCoord, yCoord, win->z_count*1.5f);
 	glm::vec3 v_up(0.0f, 1.0f, 0.0f);
 
 	glm::mat4 view_matrix = glm::lookAt(v_eye, v_center, v_up);
@@ -142,9 +140,9 @@ void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t ti
 		(GLfloat *)glm::value_ptr(view_matrix));
 
 	// set the vertex buffers
-	glVertexAttribPointer(win->gl_single.pos, 3, GL_FLOAT, GL_FALSE, 0, pyramid_positions); 
-	glVertexAttribPointer(win->gl_single.col, 4, GL_FLOAT, GL_FALSE, 0, pyramid_colors_single_draw);
-	glVertexAttribPointer(win->gl_single.trans, 3,GL_FLOAT,GL_FALSE, 0, pyramid_transforms);
+	glVertexAttribPointer(win->gl_single.pos, 3, GL_FLOAT, GL_FALSE, 0, win->pyramid_positions); 
+	glVertexAttribPointer(win->gl_single.col, 4, GL_FLOAT, GL_FALSE, 0, win->pyramid_colors_single_draw);
+	glVertexAttribPointer(win->gl_single.trans, 3,GL_FLOAT,GL_FALSE, 0, win->pyramid_transforms);
 
 	glEnableVertexAttribArray(win->gl_single.pos);
 	glEnableVertexAttribArray(win->gl_single.col);
@@ -160,7 +158,7 @@ void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t ti
 			   (GLfloat *) glm::value_ptr(model_matrix));
 
 	// draw
-	glDrawArrays(GL_TRIANGLES, 0, 18 * (x_count * y_count * z_count));
+	glDrawArrays(GL_TRIANGLES, 0, 18 * (win->x_count * win->y_count * win->z_count));
 
 	glDisableVertexAttribArray(win->gl_single.pos);
 	glDisableVertexAttribArray(win->gl_single.col);
@@ -169,32 +167,7 @@ void draw_singleDrawArrays(void *data, struct wl_callback *callback, uint32_t ti
 	// render the FPS 
 	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
 
-	// handle flips/weston
-	if (win->opaque || win->fullscreen) {
-		region = wl_compositor_create_region(win->display->compositor);
-		wl_region_add(region, 0, 0,
-			      win->geometry.width,
-			      win->geometry.height);
-		wl_surface_set_opaque_region(win->surface, region);
-		wl_region_destroy(region);
-	} else {
-		wl_surface_set_opaque_region(win->surface, NULL);
-	}
-
-	if(!win->no_swapbuffer_call)
-	{
-		if (display->swap_buffers_with_damage && buffer_age > 0) {
-			rect[0] = win->geometry.width / 4 - 1;
-			rect[1] = win->geometry.height / 4 - 1;
-			rect[2] = win->geometry.width / 2 + 2;
-			rect[3] = win->geometry.height / 2 + 2;
-			display->swap_buffers_with_damage(display->egl.dpy,
-							  win->egl_surface,
-							  rect, 1);
-		} else {
-			eglSwapBuffers(display->egl.dpy, win->egl_surface);
-		}
-	}
-	win->frames++;
+	// swap, or whatever the present mode does instead
+	present_frame(win);
 
 }
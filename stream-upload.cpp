@@ -0,0 +1,489 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "stream-upload.h"
+
+#include "shaders.h" 	// quad_verts/etc
+#include "draw-digits.h"
+#include "damage.h"
+#include "presenter.h"
+#include "offscreen.h"
+
+// glm math library
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+// frames the worker can be ahead of the uploads
+#define STREAM_FRAMES			3
+#define MAX_STREAM_TEXTURES		3
+
+#define STREAM_REPORT_US		5000000ull
+
+struct stream_state {
+	// made for these settings, the size is at most the GPU's texture size
+	unsigned int mode, format;
+	unsigned int requested_width, requested_height;
+	int width, height;
+	size_t frame_size;
+
+	// the textures (and in streamPixelBuffers mode the unpack buffers) the
+	// frames are uploaded into in turn
+	int texture_count;
+	GLuint textures[MAX_STREAM_TEXTURES];
+	GLuint pbos[MAX_STREAM_TEXTURES];
+	int next;
+
+	// the worker and its frames, either free, being made or ready to upload
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t free_cond, ready_cond;
+	bool stopping;
+	unsigned char* frames[STREAM_FRAMES];
+	std::vector<int> free_frames;
+	std::deque<int> ready_frames;
+	uint64_t frame_id;
+
+	// since the last report
+	uint64_t report_start_us;
+	uint64_t upload_us, wait_us, bytes;
+	int uploads;
+};
+
+//------------------------------------------------------------------------------
+static uint64_t monotonic_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+const char* stream_mode_name(unsigned int mode)
+{
+	switch(mode)
+	{
+		case streamSingle:			return "single texture";
+		case streamDouble:			return "double-buffered textures";
+		case streamTriple:			return "triple-buffered textures";
+		case streamPixelBuffers:	return "pixel buffer uploads";
+		default:					return "unknown";
+	}
+}
+
+//------------------------------------------------------------------------------
+const char* stream_format_name(unsigned int format)
+{
+	switch(format)
+	{
+		case streamRGBA8:		return "RGBA8";
+		case streamRGB565:		return "RGB565";
+		case streamLuminance8:	return "L8";
+		default:				return "unknown";
+	}
+}
+
+//------------------------------------------------------------------------------
+static int bytes_per_pixel(unsigned int format)
+{
+	switch(format)
+	{
+		case streamRGB565:		return 2;
+		case streamLuminance8:	return 1;
+		default:				return 4;
+	}
+}
+
+// a pattern that moves every frame, so every upload is new content
+//------------------------------------------------------------------------------
+static void make_frame(unsigned char* pixels, int width, int height, unsigned int format, uint64_t frame_id)
+{
+	unsigned int shift = (unsigned int)frame_id;
+	unsigned short* packed = (unsigned short*)pixels;
+	for(int y=0; y<height; y++)
+	{
+		for(int x=0; x<width; x++)
+		{
+			unsigned char r = ((x + shift * 8) ^ (y + shift * 4)) & 0xff;
+			unsigned char g = (x + shift * 2) & 0xff;
+			unsigned char b = (y - shift * 3) & 0xff;
+
+			switch(format)
+			{
+				case streamRGB565:
+					*packed++ = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+					break;
+				case streamLuminance8:
+					*pixels++ = r;
+					break;
+				default:
+					pixels[0] = r;
+					pixels[1] = g;
+					pixels[2] = b;
+					pixels[3] = 255;
+					pixels += 4;
+					break;
+			}
+		}
+	}
+}
+
+// makes frames while there are free ones
+//------------------------------------------------------------------------------
+static void* stream_worker(void* data)
+{
+	stream_state* state = (stream_state*)data;
+
+	pthread_mutex_lock(&state->lock);
+	for(;;)
+	{
+		while(state->free_frames.empty() && !state->stopping)
+		{
+			pthread_cond_wait(&state->free_cond, &state->lock);
+		}
+		if(state->stopping)
+		{
+			break;
+		}
+		int index = state->free_frames.back();
+		state->free_frames.pop_back();
+		uint64_t frame_id = state->frame_id++;
+		pthread_mutex_unlock(&state->lock);
+
+		make_frame(state->frames[index], state->width, state->height, state->format, frame_id);
+
+		pthread_mutex_lock(&state->lock);
+		state->ready_frames.push_back(index);
+		pthread_cond_signal(&state->ready_cond);
+	}
+	pthread_mutex_unlock(&state->lock);
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void texture_format(unsigned int format, GLenum& gl_format, GLenum& gl_type)
+{
+	switch(format)
+	{
+		case streamRGB565:
+			gl_format = GL_RGB;
+			gl_type = GL_UNSIGNED_SHORT_5_6_5;
+			break;
+		case streamLuminance8:
+			gl_format = GL_LUMINANCE;
+			gl_type = GL_UNSIGNED_BYTE;
+			break;
+		default:
+			gl_format = GL_RGBA;
+			gl_type = GL_UNSIGNED_BYTE;
+			break;
+	}
+}
+
+//------------------------------------------------------------------------------
+static stream_state* create_state(window* win, unsigned int mode)
+{
+	GLint max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+	stream_state* state = new stream_state;
+	state->mode = mode;
+	state->format = g_streamFormat;
+	state->requested_width = g_streamWidth;
+	state->requested_height = g_streamHeight;
+	state->width = std::min((int)g_streamWidth, (int)max_size);
+	state->height = std::min((int)g_streamHeight, (int)max_size);
+	state->frame_size = (size_t)state->width * state->height * bytes_per_pixel(state->format);
+
+	// the textures take the frames in turn, the unpack buffers go with them
+	state->texture_count = (streamSingle == mode) ? 1 : ((streamTriple == mode) ? 3 : 2);
+	state->next = 0;
+
+	GLenum gl_format, gl_type;
+	texture_format(state->format, gl_format, gl_type);
+	glGenTextures(state->texture_count, state->textures);
+	for(int i=0; i<state->texture_count; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, state->textures[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, gl_format, state->width, state->height, 0, gl_format, gl_type, NULL);
+	}
+
+	memset(state->pbos, 0, sizeof(state->pbos));
+	if(streamPixelBuffers == mode)
+	{
+		glGenBuffers(state->texture_count, state->pbos);
+		for(int i=0; i<state->texture_count; i++)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, state->pbos[i]);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, state->frame_size, NULL, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	pthread_mutex_init(&state->lock, NULL);
+	pthread_cond_init(&state->free_cond, NULL);
+	pthread_cond_init(&state->ready_cond, NULL);
+	state->stopping = false;
+	state->frame_id = 0;
+	for(int i=0; i<STREAM_FRAMES; i++)
+	{
+		state->frames[i] = new unsigned char[state->frame_size];
+		state->free_frames.push_back(i);
+	}
+
+	state->report_start_us = monotonic_now_us();
+	state->upload_us = state->wait_us = state->bytes = 0;
+	state->uploads = 0;
+
+	if(pthread_create(&state->thread, NULL, stream_worker, state))
+	{
+		printf("Surface %d: could not start the stream worker\n", win->surface_index);
+		exit(1);
+	}
+
+	printf("Stream upload: %dx%d %s frames, %s, %.1f MB per frame\n", state->width, state->height,
+		stream_format_name(state->format), stream_mode_name(mode), state->frame_size / (1024.0 * 1024.0));
+	return state;
+}
+
+//------------------------------------------------------------------------------
+void stream_upload_stop(window* win)
+{
+	stream_state* state = win->stream;
+	if(!state)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&state->lock);
+	state->stopping = true;
+	pthread_cond_signal(&state->free_cond);
+	pthread_mutex_unlock(&state->lock);
+	pthread_join(state->thread, NULL);
+
+	for(int i=0; i<STREAM_FRAMES; i++)
+	{
+		delete[] state->frames[i];
+	}
+	glDeleteTextures(state->texture_count, state->textures);
+	if(streamPixelBuffers == state->mode)
+	{
+		glDeleteBuffers(state->texture_count, state->pbos);
+	}
+	pthread_mutex_destroy(&state->lock);
+	pthread_cond_destroy(&state->free_cond);
+	pthread_cond_destroy(&state->ready_cond);
+
+	delete state;
+	win->stream = NULL;
+}
+
+// the oldest frame the worker made, waiting for it if there is none yet
+//------------------------------------------------------------------------------
+static int take_frame(stream_state* state)
+{
+	uint64_t start = monotonic_now_us();
+
+	pthread_mutex_lock(&state->lock);
+	while(state->ready_frames.empty())
+	{
+		pthread_cond_wait(&state->ready_cond, &state->lock);
+	}
+	int index = state->ready_frames.front();
+	state->ready_frames.pop_front();
+	pthread_mutex_unlock(&state->lock);
+
+	state->wait_us += monotonic_now_us() - start;
+	return index;
+}
+
+//------------------------------------------------------------------------------
+static void give_back_frame(stream_state* state, int index)
+{
+	pthread_mutex_lock(&state->lock);
+	state->free_frames.push_back(index);
+	pthread_cond_signal(&state->free_cond);
+	pthread_mutex_unlock(&state->lock);
+}
+
+// upload the next frame into the next texture, which is returned. The time
+// counts every call the upload makes, which is where the driver stalls when
+// the GPU still reads the texture
+//------------------------------------------------------------------------------
+static GLuint upload_frame(stream_state* state)
+{
+	int index = take_frame(state);
+	const unsigned char* pixels = state->frames[index];
+
+	GLenum gl_format, gl_type;
+	texture_format(state->format, gl_format, gl_type);
+	GLuint texture = state->textures[state->next];
+
+	uint64_t start = monotonic_now_us();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if(streamPixelBuffers == state->mode)
+	{
+		// the buffer is invalidated, so the driver can hand out new storage
+		// instead of waiting for the last upload from it
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, state->pbos[state->next]);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, state->frame_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if(mapped)
+		{
+			memcpy(mapped, pixels, state->frame_size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, state->width, state->height, gl_format, gl_type, (const void*)0);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, state->width, state->height, gl_format, gl_type, pixels);
+	}
+	state->upload_us += monotonic_now_us() - start;
+	state->bytes += state->frame_size;
+	state->uploads++;
+
+	give_back_frame(state, index);
+	state->next = (state->next + 1) % state->texture_count;
+	return texture;
+}
+
+//------------------------------------------------------------------------------
+static void report(stream_state* state)
+{
+	uint64_t now = monotonic_now_us();
+	if((now - state->report_start_us < STREAM_REPORT_US) || (0 == state->uploads))
+	{
+		return;
+	}
+
+	double upload_ms = state->upload_us / 1000.0 / state->uploads;
+	double wait_ms = state->wait_us / 1000.0 / state->uploads;
+	double bandwidth = state->upload_us ? (state->bytes / (1024.0 * 1024.0)) / (state->upload_us / 1000000.0) : 0.0;
+	printf("Stream upload: %d frames, %.0f MB/s while uploading, %.2f ms uploading and %.2f ms waiting for the worker per frame\n",
+		state->uploads, bandwidth, upload_ms, wait_ms);
+
+	state->report_start_us = now;
+	state->upload_us = state->wait_us = state->bytes = 0;
+	state->uploads = 0;
+}
+
+// Test scene: fullscreen quad with a texture uploaded every frame
+//------------------------------------------------------------------------------
+void draw_streamUpload(void *data, struct wl_callback *callback, uint32_t time_now)
+{
+	struct window *win = (window*)data;
+
+	unsigned int mode = g_streamMode;
+	if((streamPixelBuffers == mode) && (win->display->egl.client_version < 3))
+	{
+		mode = streamDouble;
+	}
+
+	// new settings start over
+	stream_state* state = win->stream;
+	if(state && ((state->mode != mode) || (state->format != g_streamFormat) ||
+		(state->requested_width != g_streamWidth) || (state->requested_height != g_streamHeight)))
+	{
+		stream_upload_stop(win);
+		state = NULL;
+	}
+	if(!state)
+	{
+		if(mode != g_streamMode)
+		{
+			printf("Pixel buffer uploads need OpenGL ES 3, using double-buffered textures\n");
+		}
+		state = create_state(win, mode);
+		win->stream = state;
+	}
+
+	// callback and weston setup
+	assert(win->callback == callback);
+	win->callback = NULL;
+
+	if (callback)
+		wl_callback_destroy(callback);
+
+	// timer for moving objects and timing frame
+	float fps = calculate_fps(win, "stream_upload", time_now);
+
+	// a new video frame fills the window every frame
+	damage_begin(win);
+	damage_add_full(win);
+
+	GLuint texture = upload_frame(state);
+
+	int width, height;
+	render_target_size(win, width, height);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glUseProgram(win->gl_tex.program);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_BLEND);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glm::mat4 identity_matrix(1.f);
+	glm::mat4 ortho_matrix = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+	glm::mat4 view_matrix = glm::lookAt(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glUniformMatrix4fv(win->gl_tex.projection_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(ortho_matrix));
+	glUniformMatrix4fv(win->gl_tex.view_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(view_matrix));
+	glUniformMatrix4fv(win->gl_tex.rotation_uniform, 1, GL_FALSE, (GLfloat *)glm::value_ptr(identity_matrix));
+	glUniform1f(win->gl_tex.shader_loop_count, 0);
+
+	// fullscreen quad
+	glVertexAttribPointer(win->gl_tex.pos, 3, GL_FLOAT, GL_FALSE, 0, quad_verts);
+	glVertexAttribPointer(win->gl_tex.tex1, 2, GL_FLOAT, GL_FALSE, 0, quad_texcoords);
+	glEnableVertexAttribArray(win->gl_tex.pos);
+	glEnableVertexAttribArray(win->gl_tex.tex1);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDisableVertexAttribArray(win->gl_tex.pos);
+	glDisableVertexAttribArray(win->gl_tex.tex1);
+
+	report(state);
+
+	// draw fps
+	g_TextRender.DrawDigits(fps, (void*)win, callback, time_now);
+
+	// swap, or whatever the present mode does instead
+	present_frame(win);
+}
@@ -0,0 +1,63 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __STREAM_UPLOAD_H__
+#define __STREAM_UPLOAD_H__
+
+#include <stdint.h>
+
+#include "main.h"
+
+// Streaming upload scene
+// Every frame a new g_streamWidth x g_streamHeight (params file lines 61,
+// 62) image in the format g_streamFormat (63) picks is uploaded with
+// glTexSubImage2D and drawn over the whole surface, like a camera or video
+// feed. The images are made by a worker thread of the surface, a few frames
+// ahead. g_streamMode (60) picks how they are uploaded: always into the
+// same texture, which makes the driver wait for the GPU to finish reading
+// it, into 2 or 3 textures in turn, or through a ring of pixel unpack
+// buffers (OpenGL ES 3). The upload bandwidth, the time the uploads take
+// and the time spent waiting for the worker are reported every 5 seconds.
+
+enum stream_mode {
+	streamSingle = 0,
+	streamDouble,
+	streamTriple,
+	streamPixelBuffers,
+	streamModeCount,
+};
+
+enum stream_format {
+	streamRGBA8 = 0,
+	streamRGB565,
+	streamLuminance8,
+	streamFormatCount,
+};
+
+void draw_streamUpload(void *data, struct wl_callback *callback, uint32_t time);
+
+const char* stream_mode_name(unsigned int mode);
+const char* stream_format_name(unsigned int format);
+
+// stop the surface's worker and free its textures, with its context current
+void stream_upload_stop(window* win);
+
+#endif // __STREAM_UPLOAD_H__
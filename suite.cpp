@@ -0,0 +1,271 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "main.h"
+#include "frame-stats.h"
+#include "frame-check.h"
+#include "capture.h"
+#include "offscreen.h"
+#include "large-texture.h"
+#include "stream-upload.h"
+#include "suite.h"
+
+// every workload renders at this size, in a window, without vsync
+#define SUITE_WIDTH 1280
+#define SUITE_HEIGHT 720
+
+// the large texture workload always draws the image that ships with the app,
+// --texture doesn't apply
+#define SUITE_TEXTURE_FILE "store1k.png"
+
+// adaptive run length used for every workload: 1% tolerance, 20 seconds max
+#define SUITE_BASE_SETTINGS \
+	"vsync=0 metrics=0 adaptive_tolerance=10 adaptive_max_seconds=20 fixed_timestep_us=0 " \
+	"flat_shader=0 blur_radius=10 pyramids_x=5 pyramids_y=5 pyramids_z=5 batches=3 " \
+	"pyramid_loops=0 dials_loops=10 longshader_loops=100 damage_tiles=0 partial_redraw=0 present=0 resize_stress=0 readback=0 " \
+	"post_downsample=2 post_blur_passes=2 post_bloom=1 post_tonemap=1 texture_raw_width=0 texture_upload_rows=256 " \
+	"multi_texture_count=8 multi_texture_size=1024 multi_texture_format=0 multi_texture_falloff=100 " \
+	"stream_mode=1 stream_width=1920 stream_height=1080 stream_format=0"
+
+struct suite_workload {
+	const char* name;
+	const char* settings;	// applied on top of SUITE_BASE_SETTINGS
+};
+
+// version 6 workloads, do not edit without bumping SUITE_VERSION
+static const suite_workload g_workloads[] = {
+	{ "dials",				"scene=0" },
+	{ "dials-heavy",		"scene=0 dials_loops=100" },
+	{ "single-1k",			"scene=1 pyramids_x=10 pyramids_y=10 pyramids_z=10" },
+	{ "single-8k",			"scene=1 pyramids_x=20 pyramids_y=20 pyramids_z=20" },
+	{ "multi-1k",			"scene=2 pyramids_x=10 pyramids_y=10 pyramids_z=10" },
+	{ "multi-8k",			"scene=2 pyramids_x=20 pyramids_y=20 pyramids_z=20" },
+	{ "batch-8k",			"scene=5 pyramids_x=20 pyramids_y=20 pyramids_z=20 batches=8" },
+	{ "texture-blur",		"scene=3" },
+	{ "texture-flat",		"scene=3 flat_shader=1" },
+	{ "longshader-100",		"scene=4" },
+	{ "longshader-500",		"scene=4 longshader_loops=500" },
+	{ "post-bloom",			"scene=8" },
+	{ "post-blur-full",		"scene=8 post_downsample=0 post_blur_passes=2 post_bloom=0 post_tonemap=0" },
+	{ "post-blur-heavy",	"scene=8 post_downsample=1 post_blur_passes=8 post_bloom=0" },
+	{ "large-texture-1k",	"scene=7" },
+	{ "multitex-8x1k",		"scene=6" },
+	{ "multitex-8x1k-565",	"scene=6 multi_texture_format=1" },
+	{ "multitex-2x2k",		"scene=6 multi_texture_count=2 multi_texture_size=2048" },
+	{ "stream-single",		"scene=9 stream_mode=0" },
+	{ "stream-double",		"scene=9 stream_mode=1" },
+	{ "stream-triple",		"scene=9 stream_mode=2" },
+	{ "stream-pbo",			"scene=9 stream_mode=3" },
+};
+
+#define WORKLOAD_COUNT (sizeof(g_workloads)/sizeof(g_workloads[0]))
+
+struct suite_result {
+	frame_summary summary;
+	bool converged;
+	bool fallback;				// the scene drew something simpler than asked for
+	DrawCases scene;
+	double pyramids;			// per frame, 0 if the scene has none
+	double loop_iterations;		// fragment loop iterations per frame, 0 if unknown
+	int width, height;
+};
+
+static suite_result g_results[WORKLOAD_COUNT];
+static unsigned int g_current = 0;
+
+//------------------------------------------------------------------------------
+static void apply_workload(window* win, unsigned int index)
+{
+	std::string settings = SUITE_BASE_SETTINGS;
+	settings += " ";
+	settings += g_workloads[index].settings;
+
+	printf("Suite: workload %u/%u '%s'\n", index + 1, (unsigned int)WORKLOAD_COUNT, g_workloads[index].name);
+	if(set_parameters(win, settings.c_str()))
+	{
+		printf("Suite: invalid settings for workload '%s'\n", g_workloads[index].name);
+		exit(1);
+	}
+}
+
+//------------------------------------------------------------------------------
+void suite_prepare(window* win)
+{
+	win->fullscreen = 0;
+	win->offscreen = win->headless ? 1 : 0;
+	g_offscreenFormat = offscreenRGB565;
+	g_offscreenDepth = 16;
+	g_offscreenSamples = 0;
+	g_offscreenWidth = 0;		// the window size
+	g_offscreenHeight = 0;
+	g_offscreenTargets = 1;
+	win->no_swapbuffer_call = false;
+	win->frame_sync = 0;
+	g_framePacing = PACING_UNTHROTTLED;
+	g_timerPeriod = 16667;
+	g_timerPhase = 0;
+	win->color_format = 0;		// RGBA8888
+	win->depth_size = 24;
+	win->stencil_size = 0;
+	win->samples = 0;
+	set_largeTexture_file(SUITE_TEXTURE_FILE);
+	win->geometry.width = SUITE_WIDTH;
+	win->geometry.height = SUITE_HEIGHT;
+	win->window_size = win->geometry;
+	g_recordMetrics = false;
+	g_frameCheckMode = frameCheckOff;
+	g_captureMode = captureOff;
+}
+
+//------------------------------------------------------------------------------
+void suite_start(window* win)
+{
+	printf("Suite: version %d, %u workloads\n", SUITE_VERSION, (unsigned int)WORKLOAD_COUNT);
+
+	g_current = 0;
+	apply_workload(win, g_current);
+}
+
+// the work done by one frame of the current workload, only counted where
+// the scene makes it exact: pyramids for the pyramid scenes, and per-pixel
+// loop iterations for the scenes whose shaded area is known. The pyramids
+// cover a varying part of the window, so pyramid workloads don't run loops
+//------------------------------------------------------------------------------
+static void record_workload(window* win, suite_result& result)
+{
+	result.summary = adaptive_run_summary();
+	result.converged = adaptive_run_converged();
+	result.scene = win->draw_case;
+	result.width = win->geometry.width;
+	result.height = win->geometry.height;
+	result.pyramids = 0;
+	result.loop_iterations = 0;
+
+	// pixel buffer uploads need OpenGL ES 3, the scene uses double-buffered
+	// textures without it
+	result.fallback = (streamUpload == win->draw_case) && (streamPixelBuffers == g_streamMode) &&
+		(win->display->egl.client_version < 3);
+
+	// without the image file the large texture scene draws the built-in one
+	if((largeTexture == win->draw_case) && largeTexture_failed())
+	{
+		result.fallback = true;
+	}
+
+	double pixels = (double)result.width * result.height;
+
+	switch(win->draw_case)
+	{
+		case singleDrawArrays:
+		case multiDrawArrays:
+		case batchDrawArrays:
+			result.pyramids = (double)win->x_count * win->y_count * win->z_count;
+			break;
+
+		case longShader:
+			result.loop_iterations = pixels * win->longShader_loop_count;
+			break;
+
+		case simpleDial:
+		{
+			// two dial faces of 3/4 of the height square each, side by side
+			// without overlapping at the suite's size; the needles don't loop
+			double face = 0.75 * result.height;
+			result.loop_iterations = 2.0 * face * face * win->dialsShader_loop_count;
+			break;
+		}
+
+		case simpleTexture:
+			// the blur's two sampling lines along a fullscreen quad, each
+			// radius/2 samples (rounded up) long; the flat shader doesn't loop
+			if(!win->texture_flat_no_rotate)
+			{
+				result.loop_iterations = pixels * 2.0 * ceil(win->texture_fetch_radius / 2.0);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+//------------------------------------------------------------------------------
+static void print_scoreboard()
+{
+	printf("\n");
+	printf("stress-weston suite version %d\n", SUITE_VERSION);
+	printf("GL_RENDERER: %s\n", (const char*)glGetString(GL_RENDERER));
+	printf("GL_VERSION: %s\n", (const char*)glGetString(GL_VERSION));
+	printf("%-18s %-18s %10s %10s %10s %14s %16s\n",
+		"workload", "scene", "size", "median ms", "p99 ms", "pyramids/s", "loop iter/s");
+
+	for(unsigned int i=0; i<WORKLOAD_COUNT; i++)
+	{
+		const suite_result& r = g_results[i];
+		double frames_per_second = (r.summary.median > 0) ? 1000000.0 / r.summary.median : 0;
+		char size[16];
+		char pyramids[32] = "-";
+		char iterations[32] = "-";
+
+		snprintf(size, sizeof(size), "%dx%d", r.width, r.height);
+		if(r.pyramids > 0)
+		{
+			snprintf(pyramids, sizeof(pyramids), "%.4g", r.pyramids * frames_per_second);
+		}
+		if(r.loop_iterations > 0)
+		{
+			snprintf(iterations, sizeof(iterations), "%.4g", r.loop_iterations * frames_per_second);
+		}
+
+		printf("%-18s %-18s %10s %10.3f %10.3f %14s %16s%s%s\n",
+			g_workloads[i].name, draw_case_name(r.scene), size,
+			r.summary.median / 1000.0, r.summary.p99 / 1000.0,
+			pyramids, iterations, r.converged ? "" : " *", r.fallback ? " !" : "");
+	}
+	printf("* did not converge within the time limit\n");
+	printf("! the driver or a file was missing, a fallback was measured\n\n");
+}
+
+//------------------------------------------------------------------------------
+bool suite_workload_complete(window* win)
+{
+	record_workload(win, g_results[g_current]);
+
+	g_current++;
+	if(g_current >= WORKLOAD_COUNT)
+	{
+		print_scoreboard();
+		return true;
+	}
+
+	apply_workload(win, g_current);
+	return false;
+}
@@ -0,0 +1,42 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __SUITE_H__
+#define __SUITE_H__
+
+// Canonical benchmark suite
+// A fixed, versioned list of workloads covering every scene. Each workload
+// runs with the adaptive run length, and a single scoreboard is printed once
+// the last one completes. Change SUITE_VERSION whenever a workload changes,
+// results from different suite versions are not comparable.
+#define SUITE_VERSION 6
+
+// pin the settings that can only be set before the surface is created
+void suite_prepare(window* win);
+
+// apply the first workload
+void suite_start(window* win);
+
+// record the workload that just completed and move to the next one
+// returns true once the whole suite is done and the scoreboard is printed
+bool suite_workload_complete(window* win);
+
+#endif // __SUITE_H__
@@ -0,0 +1,144 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "texture-decode.h"
+
+// as the GIMP headers define it
+#ifndef HEADER_PIXEL
+#define HEADER_PIXEL(data,pixel) {\
+pixel[0] = (((data[0] - 33) << 2) | ((data[1] - 33) >> 4)); \
+pixel[1] = ((((data[1] - 33) & 0xF) << 4) | ((data[2] - 33) >> 2)); \
+pixel[2] = ((((data[2] - 33) & 0x3) << 6) | ((data[3] - 33))); \
+data += 4; \
+}
+#endif
+
+// the alpha of a decoded pixel. The images were decoded into plain chars,
+// which are signed here, and the alpha styles compare them that way:
+// style 1 makes the pixels with R, G and B all in 5..127 transparent, style
+// 2 the white ones, every other pixel gets its red as alpha. Style 0 is
+// opaque
+//------------------------------------------------------------------------------
+static inline void set_alpha(char* pixel, int alpha_style)
+{
+	if(1 == alpha_style)
+	{
+		if((pixel[0]>= 5 && pixel[1]>= 5 && pixel[2]>= 5) )
+			pixel[3]=0x0;
+		else
+			pixel[3]=pixel[0];		
+	}
+	else if(2 == alpha_style)
+	{
+		if((pixel[0]== -1 && pixel[1]== -1 && pixel[2]== -1) )
+			pixel[3]=0x0;
+		else
+			pixel[3]=pixel[0];
+	}
+	else
+	{
+		pixel[3]=(char)0xff;
+	}
+}
+
+#ifdef __SSE2__
+// 4 pixels at a time: 16 characters, 6 bits each, to 4 RGBA pixels. A
+// pixel's 4 characters are one 32 bit lane, the shifts and masks regroup
+// their bits into bytes the same way HEADER_PIXEL does, and the alpha
+// styles are the same compares as set_alpha() on the lanes. Returns the
+// number of pixels decoded, the rest is left to the scalar loop
+//------------------------------------------------------------------------------
+static int decode_pixels(const char* data, unsigned char* pixels, int count, int alpha_style)
+{
+	const __m128i offset = _mm_set1_epi8(33);
+	const __m128i low6 = _mm_set1_epi32(0x3f);
+	const __m128i low4 = _mm_set1_epi32(0xf);
+	const __m128i low2 = _mm_set1_epi32(0x3);
+	const __m128i byte = _mm_set1_epi32(0xff);
+
+	int x = 0;
+	for(; x + 4 <= count; x += 4, data += 16, pixels += 16)
+	{
+		__m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)data), offset);
+
+		__m128i r = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, low6), 2),
+								 _mm_and_si128(_mm_srli_epi32(v, 12), low2));
+		__m128i g = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), low4), 4),
+								 _mm_and_si128(_mm_srli_epi32(v, 18), low4));
+		__m128i b = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 16), low2), 6),
+								 _mm_and_si128(_mm_srli_epi32(v, 24), low6));
+		r = _mm_and_si128(r, byte);
+		g = _mm_and_si128(g, byte);
+
+		__m128i alpha;
+		if(1 == alpha_style)
+		{
+			// 5..127, the chars that are >= 5 when signed
+			const __m128i four = _mm_set1_epi32(4);
+			const __m128i limit = _mm_set1_epi32(128);
+			__m128i clear = _mm_and_si128(_mm_cmpgt_epi32(r, four), _mm_cmplt_epi32(r, limit));
+			clear = _mm_and_si128(clear, _mm_and_si128(_mm_cmpgt_epi32(g, four), _mm_cmplt_epi32(g, limit)));
+			clear = _mm_and_si128(clear, _mm_and_si128(_mm_cmpgt_epi32(b, four), _mm_cmplt_epi32(b, limit)));
+			alpha = _mm_andnot_si128(clear, r);
+		}
+		else if(2 == alpha_style)
+		{
+			__m128i white = _mm_and_si128(_mm_cmpeq_epi32(r, byte), _mm_and_si128(_mm_cmpeq_epi32(g, byte), _mm_cmpeq_epi32(b, byte)));
+			alpha = _mm_andnot_si128(white, r);
+		}
+		else
+		{
+			alpha = byte;
+		}
+
+		__m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+									_mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(alpha, 24)));
+		_mm_storeu_si128((__m128i*)pixels, rgba);
+	}
+	return x;
+}
+#else
+//------------------------------------------------------------------------------
+static int decode_pixels(const char* data, unsigned char* pixels, int count, int alpha_style)
+{
+	return 0;
+}
+#endif
+
+// 'count' pixels from 'data' to 'pixels', 4 bytes each
+//------------------------------------------------------------------------------
+void decode_texture(const char* data, unsigned char* pixels, int count, int alpha_style)
+{
+	int decoded = decode_pixels(data, pixels, count, alpha_style);
+
+	data += 4 * decoded;
+	char* pIndex = (char*)pixels + 4 * decoded;
+	for(int x=decoded; x<count; x++)
+	{
+		HEADER_PIXEL(data, pIndex);
+		set_alpha(pIndex, alpha_style);
+		pIndex+=4;
+	}
+}
@@ -0,0 +1,35 @@
+// Copyright 2017 Intel Corporation
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in 
+// the Software without restriction, including without limitation the rights to 
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// Please see the readme.txt for further license information.
+#ifndef __TEXTURE_DECODE_H__
+#define __TEXTURE_DECODE_H__
+
+// Textures are embedded as GIMP C-source headers, every pixel encoded as 4
+// printable characters. This turns them into RGBA8 for asset-gen.cpp,
+// which decodes the embedded textures at build time, so it has no GL
+// dependency and isn't linked into stress-weston.
+//
+// alpha_style: 0 = opaque, 1 = clear where R, G and B are all 5 to 127,
+// 2 = clear where the pixel is white. Every other pixel of styles 1 and 2
+// gets its red as alpha.
+void decode_texture(const char* data, unsigned char* pixels, int count, int alpha_style);
+
+#endif